@@ -46,7 +46,8 @@ enum
 	AC_MemoryError,
 	AC_UnknownError,
 	AC_DestBuffOfloError,
-	AC_InvalidParameterError
+	AC_InvalidParameterError,
+	AC_CancelledError
 };
 
 /*
@@ -66,6 +67,39 @@ typedef void *(*AC_MEMMANAGEFUNCPTR)(void *ctxptr, void *old, size_t size);
 
 ACLIB_API void  AC_SetMemManager(void *ctxptr, AC_MEMMANAGEFUNCPTR func);
 
+/*
+ * Function: AC_SetMemoryLimit
+ *
+ * If this is called with a non-zero number of bytes, then hinting a glyph is
+ * given up with AC_MemoryError once the memory it allocates through the
+ * memory manager would exceed it. A limit of 0 removes the limit, which is
+ * the default.
+ *
+ * The hints of a glyph are kept in a fixed size arena, which is not counted;
+ * a glyph that does not fit in it also fails with AC_MemoryError.
+ */
+ACLIB_API void  AC_SetMemoryLimit(size_t bytes);
+
+/*
+ * Function: AC_GetMemoryStats
+ *
+ * This function returns the memory used by the last call to AutoColorString,
+ * AutoColorStringMM, AC_GetStemHistograms or AC_DeriveFontInfo, whether it
+ * succeeded or not: the number of allocations made through the memory
+ * manager (reallocations included) and the bytes they asked for, the most
+ * bytes that were allocated at once, and the most of the fixed size arena
+ * used by a glyph.
+ */
+typedef struct
+{
+	size_t allocCount;
+	size_t allocBytes;
+	size_t peakBytes;
+	size_t arenaPeak;
+} AC_MemoryStats;
+
+ACLIB_API void  AC_GetMemoryStats(AC_MemoryStats *stats);
+
 /*
  * Function: AC_SetReportCB
  *
@@ -111,6 +145,107 @@ ACLIB_API void  AC_SetReportZonesCB(AC_REPORTZONEPTR charCB, AC_REPORTZONEPTR st
 
 typedef void (*AC_RETRYPTR)(void);
 
+/*
+ * Function: AC_SetTimeLimit
+ *
+ * If this is called with a positive number of seconds, then hinting a glyph
+ * is given up once it has taken that much processor time, and the call
+ * returns AC_CancelledError instead of the hinted glyph. A time limit of 0
+ * removes the limit, which is the default.
+ */
+ACLIB_API void  AC_SetTimeLimit(double seconds);
+
+/*
+ * Function: AC_SetCancelCB
+ *
+ * If this is supplied, then the AC lib will call it every now and then while
+ * hinting a glyph, and give up on the glyph with AC_CancelledError as soon as
+ * it returns non-zero. It can be set to NULL to stop this.
+ *
+ * Glyphs of AC_GetStemHistograms and AC_DeriveFontInfo that are given up on
+ * are skipped, like the glyphs that fail to process.
+ */
+typedef int (*AC_CANCELPTR)(void);
+
+ACLIB_API void  AC_SetCancelCB(AC_CANCELPTR cancelCB);
+
+/*
+ * Function: AC_SetDraftMode
+ *
+ * If this is called with draft set to true, then AutoColorString gives
+ * quicker but coarser hints, meant for preview builds: the stem and alignment
+ * zone hints are found as usual, but hint substitution, flex, the shuffling
+ * of subpaths and the second hinting pass after fixing up the path are all
+ * skipped. Draft mode is off by default.
+ */
+ACLIB_API void  AC_SetDraftMode(int draft);
+
+/*
+ * Function: AC_GetStemHistograms
+ *
+ * This function runs the stem analysis over glyphCount glyphs in the bez
+ * format, all sharing the fontinfo, and returns the stem widths it finds
+ * aggregated over all of them. Nothing is reported through the callbacks of
+ * AC_SetReportStemsCB while it runs, and the reporting mode that was set
+ * before the call is restored afterwards.
+ *
+ * There is one histogram each for straight and curved horizontal and
+ * vertical stems. Each entry holds a stem width (in the same fixed point
+ * units as the stem callbacks), the number of stems with that width and the
+ * number of glyphs with at least one such stem; entries are sorted by width.
+ * If allStems is false, the curved histograms are left empty.
+ *
+ * Glyphs that fail to process are skipped. The histograms must be released
+ * with AC_FreeStemHistograms.
+ */
+typedef struct
+{
+	int width;
+	int count;
+	int glyphCount;
+} AC_StemWidthCount;
+
+typedef struct
+{
+	AC_StemWidthCount* widths;
+	size_t length;
+} AC_StemHistogram;
+
+typedef struct
+{
+	AC_StemHistogram hStraight;
+	AC_StemHistogram hCurved;
+	AC_StemHistogram vStraight;
+	AC_StemHistogram vCurved;
+} AC_StemHistograms;
+
+ACLIB_API int AC_GetStemHistograms(const char *fontinfo, const char **srcbezdata, size_t glyphCount, unsigned int allStems, AC_StemHistograms *histograms);
+
+ACLIB_API void AC_FreeStemHistograms(AC_StemHistograms *histograms);
+
+/*
+ * Function: AC_DeriveFontInfo
+ *
+ * This function derives a fontinfo from glyphCount glyphs in the bez format,
+ * for fonts that have no alignment zones or stem widths yet. The glyphs are
+ * run through the zone and the stem analysis, and the result is written to
+ * fontinfo as a null terminated C string that can be passed to
+ * AutoColorString.
+ *
+ * BaselineYCoord, CapHeight and LcHeight are the most common bottom and
+ * tops of the glyphs with flat ends among E F H I K L T X Z and v w x y z,
+ * and their overshoots are taken from C G O Q S and c e o s. LcHeight is
+ * left out if the font has none of those lower case glyphs. DominantV and
+ * DominantH are the most common stem widths, and StemSnapV and StemSnapH
+ * list the common widths within a third of them, at most 12 each. FlexOK is
+ * left out, as it is the designer's choice, so flex hints are not added.
+ *
+ * fontinfo must be allocated before the call and a pointer to its length
+ * passed as *length. If the space allocated is insufficient, an error will be
+ * returned and *length will be set to the desired size.
+ */
+ACLIB_API int AC_DeriveFontInfo(const char **srcbezdata, size_t glyphCount, int unitsPerEm, char *fontinfo, size_t *length);
+
 /*
  * Function: AutoColorString
  *
@@ -126,6 +261,48 @@ typedef void (*AC_RETRYPTR)(void);
  */
 ACLIB_API int AutoColorString(const char *srcbezdata, const char *fontinfo, char *dstbezdata, size_t *length, int allowEdit, int allowHintSub, int roundCoords, int debug);
 
+/*
+ * Function: AC_ParseFontInfo
+ *
+ * This function parses fontinfo, a null terminated C string in the same form
+ * as for AutoColorString, so that many glyphs can be hinted with it by
+ * AutoColorStringFI without parsing it again for each. The parsed fontinfo is
+ * allocated through the memory manager and must be released with
+ * AC_FreeFontInfo.
+ */
+typedef struct _acfontinfo AC_FontInfo;
+
+ACLIB_API int AC_ParseFontInfo(const char *fontinfo, AC_FontInfo **parsed);
+
+ACLIB_API void AC_FreeFontInfo(AC_FontInfo *parsed);
+
+/*
+ * Function: AutoColorStringFI
+ *
+ * This function is AutoColorString with a fontinfo parsed by
+ * AC_ParseFontInfo.
+ */
+ACLIB_API int AutoColorStringFI(const char *srcbezdata, const AC_FontInfo *fontinfo, char *dstbezdata, size_t *length, int allowEdit, int allowHintSub, int roundCoords, int debug);
+
+/*
+ * Function: AutoColorStringMM
+ *
+ * This function hints nmasters masters of one glyph together, so that they
+ * get compatible hints: srcbezdata points to the bez data of each master,
+ * which must all have the same path elements. The first master is hinted
+ * like AutoColorString does without changing its path, and each hint of it
+ * is moved in the other masters to where the path elements it comes from
+ * are, so that every master has the same hints in the same order and the
+ * same hint substitutions. Flex is not added.
+ *
+ * The hinted masters are returned through the buffers dstbezdata[i], which
+ * must be allocated before the call with their lengths passed in lengths[i].
+ * If any is too small, an error will be returned and every lengths[i] will be
+ * set to the desired size. If the masters are not compatible,
+ * AC_InvalidParameterError is returned.
+ */
+ACLIB_API int AutoColorStringMM(const char **srcbezdata, const char *fontinfo, size_t nmasters, char **dstbezdata, size_t *lengths, int allowHintSub, int roundCoords, int debug);
+
 /*
  * Function: AC_initCallGlobals
  *
@@ -14,6 +14,16 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
 #if !defined(_MSC_VER) || _MSC_VER >= 1800
 #include <stdbool.h>
 #else
@@ -31,6 +41,7 @@ const char* dfltExt = ".new";
 char* bezName = NULL;
 char* fileSuffix = NULL;
 FILE* reportFile = NULL;
+long reportStart = -1; /* offset of the glyph report in a glyph container */
 
 bool verbose = true; /* if true don't number of characters processed. */
 
@@ -48,8 +59,12 @@ printUsage(void)
 {
     fprintf(stdout, "Usage: autohintexe [-u] [-h]\n");
     fprintf(stdout, "       autohintexe  -f <font info name> [-e] [-n] "
-                    "[-q] [-s <suffix>] [-ra] [-rs] -a] [<file1> <file2> "
-                    "... <filen>]\n");
+                    "[-q] [-s <suffix>] [-ra] [-rs] -a] [-c] [<file1> "
+                    "<file2> ... <filen>]\n");
+    fprintf(stdout, "       autohintexe  -rf <units per em> <file1> "
+                    "[<file2> ... <filen>]\n");
+    fprintf(stdout, "       autohintexe  [-e] [-n] [-d] [-q] -S | -U <socket "
+                    "path>\n");
     printVersions();
 }
 
@@ -80,6 +95,17 @@ printHelp(void)
                     "change glyph. Default extension is '.rpt'\n");
     fprintf(stdout, "   -a Modifies -ra and -rs: Includes stems between "
                     "curved lines: default is to omit these.\n");
+    fprintf(stdout, "   -rf <units per em> Derive font info from all the "
+                    "glyphs and write it to stdout. Does not hint or change "
+                    "glyph. -f is not needed.\n");
+    fprintf(stdout, "   -c The files are glyph containers rather than bez "
+                    "files. See main.c for the format.\n");
+    fprintf(stdout, "   -S Serve hinting requests read from stdin, writing "
+                    "the results to stdout. See main.c for the protocol.\n");
+#ifndef _WIN32
+    fprintf(stdout, "   -U <path> Serve hinting requests on a Unix domain "
+                    "socket at <path>, one connection at a time.\n");
+#endif
     fprintf(stdout, "   -v print versions.\n");
 }
 
@@ -126,6 +152,10 @@ static void
 reportRetry(void)
 {
     if (reportFile != NULL) {
+        if (reportStart >= 0) {
+            fseek(reportFile, reportStart, SEEK_SET);
+            return;
+        }
         fclose(reportFile);
         openReportFile(bezName, fileSuffix);
     }
@@ -171,6 +201,55 @@ getFileData(char* name)
     return data;
 }
 
+typedef struct
+{
+    char* data;
+    size_t size;
+    bool mapped;
+} FileData;
+
+/* Loads a file as a null terminated string, which may be written to without
+ * changing the file. The file is mapped into memory when the page tail past
+ * its end, which the system fills with zeros, can serve as the terminator;
+ * otherwise it is read into an allocated buffer. */
+static void
+loadFileData(char* name, FileData* file)
+{
+#ifndef _WIN32
+    struct stat filestat;
+    int fd = open(name, O_RDONLY);
+    if (fd >= 0 && fstat(fd, &filestat) == 0 && filestat.st_size > 0 &&
+        filestat.st_size % sysconf(_SC_PAGESIZE) != 0) {
+        void* data = mmap(NULL, filestat.st_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            close(fd);
+            file->data = data;
+            file->size = filestat.st_size;
+            file->mapped = true;
+            return;
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+#endif
+    file->data = getFileData(name);
+    file->size = strlen(file->data);
+    file->mapped = false;
+}
+
+static void
+releaseFileData(FileData* file)
+{
+#ifndef _WIN32
+    if (file->mapped) {
+        munmap(file->data, file->size);
+        return;
+    }
+#endif
+    free(file->data);
+}
+
 static void
 writeFileData(char* name, char* output, char* fSuffix)
 {
@@ -227,6 +306,544 @@ closeReportFile(void)
         fclose(reportFile);
 }
 
+/* Glyph containers.
+ *
+ * With -c, each file is a container holding many glyphs, so that a whole font
+ * can be hinted without opening, reading and writing a file per glyph. A
+ * container starts with a header line and an index line per glyph, followed
+ * by the glyph data:
+ *
+ *   %BEZCONTAINER <glyph count>
+ *   <offset> <length> <glyph name>
+ *   ...
+ *   <glyph data>
+ *   ...
+ *
+ * The offset of a glyph is from the start of the file, and its data is
+ * followed by a newline that is not counted in its length. The results, or
+ * the reports with -ra and -rs, are written to a container of the same form
+ * named after the input container. */
+
+static const char* containerTag = "%BEZCONTAINER";
+
+typedef struct
+{
+    char* name;
+    char* data;
+    size_t length;
+} ContainerGlyph;
+
+/* Splits the next line off *pos, null terminating it in place. */
+static char*
+nextLine(char** pos, char* end)
+{
+    char* line = *pos;
+    char* eol;
+    if (line >= end || (eol = memchr(line, '\n', end - line)) == NULL)
+        return NULL;
+    *eol = '\0';
+    *pos = eol + 1;
+    return line;
+}
+
+static ContainerGlyph*
+parseContainer(char* name, FileData* file, unsigned long* count)
+{
+    char* pos = file->data;
+    char* end = file->data + file->size;
+    char* line = nextLine(&pos, end);
+    char tag[32];
+    ContainerGlyph* glyphs = NULL;
+    unsigned long i;
+
+    if (line == NULL || sscanf(line, "%31s %lu", tag, count) != 2 ||
+        strcmp(tag, containerTag) != 0 || *count > file->size)
+        goto bad;
+
+    glyphs = malloc((*count + 1) * sizeof(ContainerGlyph));
+    if (glyphs == NULL) {
+        fprintf(stdout, "Error. Could not allocate memory for the index of "
+                        "container '%s'.\n",
+                name);
+        exit(AC_FatalError);
+    }
+    for (i = 0; i < *count; i++) {
+        unsigned long offset, length;
+        int nameStart = 0;
+        line = nextLine(&pos, end);
+        if (line == NULL ||
+            sscanf(line, "%lu %lu %n", &offset, &length, &nameStart) != 2 ||
+            nameStart == 0 || offset >= file->size ||
+            length >= file->size - offset ||
+            file->data[offset + length] != '\n')
+            goto bad;
+        glyphs[i].name = line + nameStart;
+        glyphs[i].data = file->data + offset;
+        glyphs[i].length = length;
+    }
+
+    /* Only once the whole index is read, as the data could overlap it. */
+    for (i = 0; i < *count; i++)
+        glyphs[i].data[glyphs[i].length] = '\0';
+    return glyphs;
+
+bad:
+    fprintf(stdout, "Error. '%s' is not a valid glyph container.\n", name);
+    exit(AC_FatalError);
+    return NULL;
+}
+
+static void
+writeContainerIndex(FILE* fp, ContainerGlyph* glyphs, unsigned long count,
+                    size_t* offsets, size_t* lengths)
+{
+    unsigned long i;
+    fseek(fp, 0, SEEK_SET);
+    fprintf(fp, "%s %lu\n", containerTag, count);
+    /* Fixed width, so the index can be written before the offsets are known
+     * and rewritten after. */
+    for (i = 0; i < count; i++)
+        fprintf(fp, "%012lu %012lu %s\n", (unsigned long)offsets[i],
+                (unsigned long)lengths[i], glyphs[i].name);
+}
+
+static int
+hintContainer(char* name, char* fontinfo, int allowEdit, int allowHintSub,
+              int roundCoords, int debug, bool report)
+{
+    FileData file;
+    ContainerGlyph* glyphs;
+    unsigned long count, i;
+    size_t *offsets, *lengths;
+    char* outName;
+    FILE* fp;
+    char* output = NULL;
+    size_t outputCapacity = 0;
+    int result = AC_Success;
+
+    loadFileData(name, &file);
+    glyphs = parseContainer(name, &file, &count);
+    offsets = calloc(count + 1, sizeof(size_t));
+    lengths = calloc(count + 1, sizeof(size_t));
+    outName = malloc(strlen(name) + strlen(fileSuffix) + 1);
+    if (offsets == NULL || lengths == NULL || outName == NULL) {
+        fprintf(stdout, "Error. Could not allocate memory for container "
+                        "'%s'.\n",
+                name);
+        exit(AC_FatalError);
+    }
+    sprintf(outName, "%s%s", name, fileSuffix);
+    fp = fopen(outName, "wb");
+    if (fp == NULL) {
+        fprintf(stdout, "Error. Could not open file '%s' for writing.\n",
+                outName);
+        exit(AC_FatalError);
+    }
+    writeContainerIndex(fp, glyphs, count, offsets, lengths);
+    if (report)
+        reportFile = fp;
+
+    for (i = 0; i < count && result == AC_Success; i++) {
+        size_t outputsize;
+        bezName = glyphs[i].name;
+        offsets[i] = ftell(fp);
+        reportStart = report ? (long)offsets[i] : -1;
+
+        /* An empty entry has nothing to hint and stays empty. */
+        if (glyphs[i].length == 0) {
+            fputc('\n', fp);
+            continue;
+        }
+
+        if (outputCapacity < 4 * glyphs[i].length) {
+            free(output);
+            outputCapacity = 4 * glyphs[i].length;
+            output = malloc(outputCapacity);
+            if (output == NULL) {
+                result = AC_MemoryError;
+                break;
+            }
+        }
+        outputsize = outputCapacity;
+        result = AutoColorString(glyphs[i].data, fontinfo, output, &outputsize,
+                                 allowEdit, allowHintSub, roundCoords, debug);
+        if (result == AC_DestBuffOfloError) {
+            if (report)
+                fseek(fp, offsets[i], SEEK_SET);
+            free(output);
+            outputCapacity = outputsize;
+            output = malloc(outputCapacity);
+            if (output == NULL) {
+                result = AC_MemoryError;
+                break;
+            }
+            AC_SetReportCB(reportCB, false);
+            result =
+              AutoColorString(glyphs[i].data, fontinfo, output, &outputsize,
+                              allowEdit, allowHintSub, roundCoords, debug);
+            AC_SetReportCB(reportCB, verbose);
+        }
+
+        if (result == AC_Success && !report)
+            fwrite(output, 1, strlen(output), fp);
+        lengths[i] = ftell(fp) - offsets[i];
+        fputc('\n', fp);
+    }
+
+    if (result == AC_Success) {
+#ifndef _WIN32
+        /* A retried report may have left a longer attempt behind. */
+        fflush(fp);
+        if (ftruncate(fileno(fp), ftell(fp)) != 0)
+            result = AC_FatalError;
+#endif
+        writeContainerIndex(fp, glyphs, count, offsets, lengths);
+    }
+    fclose(fp);
+    if (result != AC_Success) {
+        fprintf(stdout, "Error. Could not process glyph '%s' in container "
+                        "'%s'.\n",
+                bezName, name);
+        remove(outName);
+    }
+
+    reportFile = NULL;
+    reportStart = -1;
+    free(output);
+    free(outName);
+    free(offsets);
+    free(lengths);
+    free(glyphs);
+    releaseFileData(&file);
+    return result;
+}
+
+static int
+deriveFontInfo(char* files[], int numFiles, int unitsPerEm, bool containers)
+{
+    int i, result;
+    char* fontinfo;
+    size_t fontinfosize = 1024;
+    size_t glyphCount = 0;
+    FileData* fileData = malloc(numFiles * sizeof(FileData));
+    const char** bezdata = containers ? NULL : malloc(numFiles * sizeof(char*));
+
+    if (fileData == NULL || (!containers && bezdata == NULL)) {
+        fprintf(stdout, "Error. Could not allocate memory for bez data.\n");
+        return AC_MemoryError;
+    }
+    for (i = 0; i < numFiles; i++) {
+        loadFileData(files[i], &fileData[i]);
+        if (containers) {
+            unsigned long count, j;
+            ContainerGlyph* glyphs =
+              parseContainer(files[i], &fileData[i], &count);
+            bezdata =
+              realloc(bezdata, (glyphCount + count + 1) * sizeof(char*));
+            if (bezdata == NULL) {
+                fprintf(stdout,
+                        "Error. Could not allocate memory for bez data.\n");
+                return AC_MemoryError;
+            }
+            for (j = 0; j < count; j++)
+                bezdata[glyphCount++] = glyphs[j].data;
+            free(glyphs);
+        } else {
+            bezdata[glyphCount++] = fileData[i].data;
+        }
+    }
+
+    fontinfo = malloc(fontinfosize);
+    result = AC_MemoryError;
+    if (fontinfo != NULL)
+        result = AC_DeriveFontInfo(bezdata, glyphCount, unitsPerEm, fontinfo,
+                                   &fontinfosize);
+    if (result == AC_DestBuffOfloError) {
+        free(fontinfo);
+        fontinfo = malloc(fontinfosize);
+        result = AC_MemoryError;
+        if (fontinfo != NULL)
+            result = AC_DeriveFontInfo(bezdata, glyphCount, unitsPerEm,
+                                       fontinfo, &fontinfosize);
+    }
+    if (result == AC_MemoryError)
+        fprintf(stdout, "Error. Could not allocate memory for font info.\n");
+    if (result == AC_Success)
+        printf("%s\n", fontinfo);
+
+    free(fontinfo);
+    for (i = 0; i < numFiles; i++)
+        releaseFileData(&fileData[i]);
+    free(fileData);
+    free(bezdata);
+    return result;
+}
+
+/* Server mode.
+ *
+ * With -S, requests are read from stdin and the responses are written to
+ * stdout; with -U, the same requests are served on a Unix domain socket. The
+ * registered font infos stay around for the life of the process, so that a
+ * client can hint many glyphs without starting a new process for each.
+ *
+ * Every request is a header line, followed for fontinfo and hint requests by
+ * a payload of exactly <length> bytes:
+ *
+ *   fontinfo <length>         registers a font info, the response payload is
+ *                             its handle.
+ *   hint <handle> <length>    hints the bez glyph data in the payload with a
+ *                             registered font info, the response payload is
+ *                             the hinted glyph.
+ *   release <handle>          forgets a registered font info.
+ *   quit                      stops the server.
+ *
+ * Every response is a header line, "ok <length>" or "error <length>",
+ * followed by a payload of <length> bytes; for errors it is the message.
+ * A font info is parsed once, when it is registered. A request that cannot
+ * be read, or whose payload is longer than MAXPAYLOAD, gets an error response
+ * too, and then the input is given up on, as its framing is lost. Library
+ * messages are written to stderr. */
+
+/* Far more than any glyph or font info needs, and small enough that the
+ * buffers sized from it cannot overflow. */
+#define MAXPAYLOAD (64UL * 1024 * 1024)
+
+static AC_FontInfo** serverFontInfos = NULL;
+static unsigned long numServerFontInfos = 0;
+
+static void
+serverReportCB(char* msg)
+{
+    fprintf(stderr, "%s\n", msg);
+}
+
+static void
+writeResponse(FILE* out, const char* status, const char* data, size_t length)
+{
+    fprintf(out, "%s %lu\n", status, (unsigned long)length);
+    fwrite(data, 1, length, out);
+    fflush(out);
+}
+
+static void
+writeError(FILE* out, const char* message)
+{
+    writeResponse(out, "error", message, strlen(message));
+}
+
+static char*
+readPayload(FILE* in, unsigned long length)
+{
+    char* data = malloc(length + 1);
+    if (data == NULL)
+        return NULL;
+    if (fread(data, 1, length, in) != length) {
+        free(data);
+        return NULL;
+    }
+    data[length] = '\0';
+    return data;
+}
+
+static AC_FontInfo*
+getServerFontInfo(unsigned long handle)
+{
+    if (handle == 0 || handle > numServerFontInfos)
+        return NULL;
+    return serverFontInfos[handle - 1];
+}
+
+/* Makes the output buffer at least capacity bytes long, keeping it for the
+ * next requests. */
+static bool
+growOutput(char** output, size_t* outputCapacity, size_t capacity)
+{
+    if (*outputCapacity >= capacity)
+        return true;
+    free(*output);
+    *output = malloc(capacity);
+    *outputCapacity = *output != NULL ? capacity : 0;
+    return *output != NULL;
+}
+
+/* Serves requests until the input ends, a request cannot be read or a quit
+ * request arrives. Returns false for the latter. */
+static bool
+serveRequests(FILE* in, FILE* out, int allowEdit, int allowHintSub,
+              int roundCoords, int debug)
+{
+    char header[256], command[32];
+    unsigned long handle, length;
+    int result;
+    static char* output = NULL;
+    static size_t outputCapacity = 0;
+
+    while (fgets(header, sizeof(header), in) != NULL) {
+        char* payload;
+        if (strchr(header, '\n') == NULL && !feof(in)) {
+            writeError(out, "Request header too long.");
+            return true;
+        }
+        if (sscanf(header, "%31s", command) != 1) {
+            writeError(out, "Empty request.");
+            return true;
+        }
+        if (!strcmp(command, "fontinfo") &&
+            sscanf(header, "%*s %lu", &length) == 1) {
+            AC_FontInfo** fontInfos;
+            AC_FontInfo* fontinfo;
+            char reply[32];
+            if (length > MAXPAYLOAD) {
+                writeError(out, "Request payload too long.");
+                return true;
+            }
+            payload = readPayload(in, length);
+            if (payload == NULL) {
+                writeError(out, "Could not read the font info.");
+                return true;
+            }
+            result = AC_ParseFontInfo(payload, &fontinfo);
+            free(payload);
+            if (result != AC_Success) {
+                writeError(out, "Could not parse the font info.");
+                continue;
+            }
+            fontInfos = realloc(serverFontInfos, (numServerFontInfos + 1) *
+                                                   sizeof(AC_FontInfo*));
+            if (fontInfos == NULL) {
+                AC_FreeFontInfo(fontinfo);
+                writeError(out, "Out of memory.");
+                continue;
+            }
+            serverFontInfos = fontInfos;
+            serverFontInfos[numServerFontInfos++] = fontinfo;
+            snprintf(reply, sizeof(reply), "%lu", numServerFontInfos);
+            writeResponse(out, "ok", reply, strlen(reply));
+        } else if (!strcmp(command, "hint") &&
+                   sscanf(header, "%*s %lu %lu", &handle, &length) == 2) {
+            AC_FontInfo* fontinfo;
+            size_t outputsize;
+            if (length > MAXPAYLOAD) {
+                writeError(out, "Request payload too long.");
+                return true;
+            }
+            payload = readPayload(in, length);
+            if (payload == NULL) {
+                writeError(out, "Could not read the glyph.");
+                return true;
+            }
+            fontinfo = getServerFontInfo(handle);
+            if (fontinfo == NULL) {
+                free(payload);
+                writeError(out, "Unknown font info handle.");
+                continue;
+            }
+            result = AC_MemoryError;
+            if (growOutput(&output, &outputCapacity, 4 * length + 1)) {
+                outputsize = outputCapacity;
+                result = AutoColorStringFI(payload, fontinfo, output,
+                                           &outputsize, allowEdit,
+                                           allowHintSub, roundCoords, debug);
+            }
+            if (result == AC_DestBuffOfloError) {
+                result = AC_MemoryError;
+                if (growOutput(&output, &outputCapacity, outputsize)) {
+                    result = AutoColorStringFI(payload, fontinfo, output,
+                                               &outputsize, allowEdit,
+                                               allowHintSub, roundCoords,
+                                               debug);
+                }
+            }
+            free(payload);
+            if (result == AC_Success) {
+                writeResponse(out, "ok", output, strlen(output));
+            } else {
+                char message[64];
+                snprintf(message, sizeof(message),
+                         "Hinting failed with error %d.", result);
+                writeError(out, message);
+            }
+        } else if (!strcmp(command, "release") &&
+                   sscanf(header, "%*s %lu", &handle) == 1) {
+            if (getServerFontInfo(handle) == NULL) {
+                writeError(out, "Unknown font info handle.");
+                continue;
+            }
+            AC_FreeFontInfo(serverFontInfos[handle - 1]);
+            serverFontInfos[handle - 1] = NULL;
+            writeResponse(out, "ok", "", 0);
+        } else if (!strcmp(command, "quit")) {
+            writeResponse(out, "ok", "", 0);
+            return false;
+        } else {
+            /* The framing is lost, so give up on this input. */
+            writeError(out, "Invalid request.");
+            return true;
+        }
+    }
+    return true;
+}
+
+#ifndef _WIN32
+static int
+serveSocket(const char* path, int allowEdit, int allowHintSub,
+            int roundCoords, int debug)
+{
+    struct sockaddr_un addr;
+    int listenFd;
+    bool more = true;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stdout, "Error. Socket path '%s' is too long.\n", path);
+        return AC_InvalidParameterError;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        fprintf(stdout, "Error. Could not create socket.\n");
+        return AC_FatalError;
+    }
+    unlink(path);
+    if (bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(listenFd, 4) < 0) {
+        fprintf(stdout, "Error. Could not listen on socket '%s'.\n", path);
+        close(listenFd);
+        return AC_FatalError;
+    }
+
+    /* A client going away must not take the server with it. */
+    signal(SIGPIPE, SIG_IGN);
+
+    while (more) {
+        FILE *in, *out;
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        in = fdopen(fd, "rb");
+        out = fdopen(dup(fd), "wb");
+        if (in != NULL && out != NULL)
+            more = serveRequests(in, out, allowEdit, allowHintSub,
+                                 roundCoords, debug);
+        if (in != NULL)
+            fclose(in);
+        else
+            close(fd);
+        if (out != NULL)
+            fclose(out);
+    }
+
+    close(listenFd);
+    unlink(path);
+    return AC_Success;
+}
+#endif
+
 int
 main(int argc, char* argv[])
 {
@@ -249,6 +866,10 @@ main(int argc, char* argv[])
     char* current_arg;
     int16_t total_files = 0;
     int result, argi;
+    int deriveUnitsPerEm = 0;
+    bool serveStdio = false;
+    bool containers = false;
+    char* socketPath = NULL;
 
     badParam = false;
     debug = false;
@@ -350,6 +971,24 @@ main(int argc, char* argv[])
             case 'a':
                 allStems = true;
                 break;
+            case 'c':
+                containers = true;
+                break;
+            case 'S':
+                serveStdio = true;
+                break;
+#ifndef _WIN32
+            case 'U':
+                socketPath = argv[++argi];
+                if ((socketPath == NULL) || (socketPath[0] == '\0') ||
+                    (socketPath[0] == '-')) {
+                    fprintf(stdout, "Error. Illegal command line. \"-U\" "
+                                    "option must be followed by a socket "
+                                    "path.\n");
+                    exit(1);
+                }
+                break;
+#endif
 
             case 'r':
                 allowEdit = allowHintSub = false;
@@ -365,6 +1004,16 @@ main(int argc, char* argv[])
                         AC_SetReportStemsCB(hstemCB, vstemCB, allStems);
                         report = true;
                         break;
+                    case 'f':
+                        if (++argi < argc)
+                            deriveUnitsPerEm = atoi(argv[argi]);
+                        if (deriveUnitsPerEm <= 0) {
+                            fprintf(stdout, "Error. Illegal command line. "
+                                            "\"-rf\" option must be followed "
+                                            "by the units per em.\n");
+                            exit(1);
+                        }
+                        break;
                     default:
                         fprintf(stdout, "Error. %s is an invalid parameter.\n",
                                 current_arg);
@@ -385,12 +1034,26 @@ main(int argc, char* argv[])
         }
     }
 
+    if (serveStdio || socketPath != NULL) {
+        if (badParam)
+            exit(AC_InvalidParameterError);
+        AC_SetReportCB(serverReportCB, verbose);
+#ifndef _WIN32
+        if (socketPath != NULL)
+            return serveSocket(socketPath, allowEdit, allowHintSub,
+                               roundCoords, debug);
+#endif
+        serveRequests(stdin, stdout, allowEdit, allowHintSub, roundCoords,
+                      debug);
+        return 0;
+    }
+
     if (firstFileNameIndex == -1) {
         fprintf(stdout,
                 "Error. Illegal command line. Must provide bez file name.\n");
         badParam = true;
     }
-    if (fontInfoFileName == NULL) {
+    if (fontInfoFileName == NULL && deriveUnitsPerEm == 0) {
         fprintf(
           stdout,
           "Error. Illegal command line. Must provide font info file name.\n");
@@ -401,14 +1064,37 @@ main(int argc, char* argv[])
         exit(AC_InvalidParameterError);
 
     AC_SetReportCB(reportCB, verbose);
+
+    if (argumentIsBezData && (deriveUnitsPerEm > 0 || containers)) {
+        fprintf(stdout, "Error. Illegal command line. \"-b\" can't be used "
+                        "together with \"-rf\" or \"-c\".\n");
+        exit(AC_InvalidParameterError);
+    }
+
+    if (deriveUnitsPerEm > 0)
+        return deriveFontInfo(&argv[firstFileNameIndex], total_files,
+                              deriveUnitsPerEm, containers);
+
+    if (containers) {
+        for (argi = firstFileNameIndex; argi < argc; argi++) {
+            result = hintContainer(argv[argi], fontinfo, allowEdit,
+                                   allowHintSub, roundCoords, debug, report);
+            if (result != AC_Success)
+                exit(result);
+        }
+        return 0;
+    }
+
     argi = firstFileNameIndex - 1;
     while (++argi < argc) {
+        FileData file;
         char* bezdata;
         char* output;
         size_t outputsize = 0;
         bezName = argv[argi];
         if (!argumentIsBezData) {
-            bezdata = getFileData(bezName);
+            loadFileData(bezName, &file);
+            bezdata = file.data;
         } else {
             bezdata = bezName;
         }
@@ -452,6 +1138,8 @@ main(int argc, char* argv[])
         }
 
         free(output);
+        if (!argumentIsBezData)
+            releaseFileData(&file);
         if (result != AC_Success)
             exit(result);
     }
@@ -7,6 +7,8 @@
  * This license is available at: http://opensource.org/licenses/Apache-2.0.
  */
 
+#include <time.h>
+
 #include "ac.h"
 #include "fontinfo.h"
 
@@ -15,6 +17,7 @@
 PPathElt gPathStart, gPathEnd;
 bool gYgoesUp;
 bool gUseV, gUseH, gAutoVFix, gAutoHFix, gAutoLinearCurveFix, gEditChar;
+bool gDraftMode;
 bool gAutoExtraDebug, gDebugColorPath, gDebug, gLogging;
 bool gShowVs, gShowHs, gListClrInfo;
 bool gReportErrors, gHasFlex, gFlexOK, gFlexStrict, gShowClrInfo, gBandError;
@@ -48,6 +51,12 @@ AC_REPORTSTEMPTR gAddVStemCB = NULL;
 AC_REPORTZONEPTR gAddCharExtremesCB = NULL;
 AC_REPORTZONEPTR gAddStemExtremesCB = NULL;
 AC_RETRYPTR gReportRetryCB = NULL;
+double gTimeLimit = 0;
+AC_CANCELPTR gCancelCB = NULL;
+
+/* when the glyph being hinted runs out of time, and the polls so far */
+static clock_t deadline;
+static unsigned int cancelPolls;
 
 #define VMSIZE (1000000)
 static unsigned char *vmfree, *vmlast, vm[VMSIZE];
@@ -60,9 +69,11 @@ Alloc(int32_t sz)
     sz = (sz + 3) & ~3; /* make size a multiple of 4 */
     s = vmfree;
     vmfree += sz;
+    if ((size_t)(vmfree - vm) > gMemStats.arenaPeak)
+        gMemStats.arenaPeak = vmfree - vm;
     if (vmfree > vmlast) /* Error! need to make VMSIZE bigger */
     {
-        LogMsg(LOGERROR, FATALERROR,
+        LogMsg(LOGERROR, MEMORYERROR,
                "Exceeded VM size for hints in glyph: %s.\n", gGlyphName);
     }
     return s;
@@ -87,6 +98,7 @@ InitData(const ACFontInfo* fontinfo, int32_t reason)
             gGhostLength = PSDist(4);
             gBendLength = PSDist(2);
             gBendTan = 577;      /* 30 sin 30 cos div abs == .57735 */
+            /* QuoIsZero in head.c is only exact for gTheta <= .38 */
             gTheta = (float).38; /* must be <= .38 for Ryumin-Light-32 c49*/
             gPruneA = FixInt(50);
             gPruneC = 100;
@@ -130,7 +142,11 @@ InitData(const ACFontInfo* fontinfo, int32_t reason)
             }
         /* fall through */
         case RESTART:
-            memset((void*)vm, 0x0, VMSIZE);
+            /* Only the part used since the last reset needs clearing, the
+             * rest of the arena is still zero. */
+            if (vmfree != NULL)
+                memset((void*)vm, 0x0,
+                       vmfree < vmlast ? (size_t)(vmfree - vm) : VMSIZE);
             vmfree = vm;
             vmlast = vm + VMSIZE;
 
@@ -147,11 +163,43 @@ InitData(const ACFontInfo* fontinfo, int32_t reason)
     }
 }
 
+void
+StartTimeLimit(void)
+{
+    clock_t ticks = (clock_t)(gTimeLimit * CLOCKS_PER_SEC);
+
+    deadline = clock() + (ticks > 0 ? ticks : 1);
+    cancelPolls = 0;
+}
+
+/* Gives up on the glyph, by way of the error handler, once its time limit
+ * has passed or the cancel callback asks to. This is called from the loops
+ * that can run for long on complex glyphs, so the clock and the callback are
+ * only looked at every few calls. */
+void
+CheckCancel(void)
+{
+    if (gTimeLimit <= 0 && gCancelCB == NULL)
+        return;
+    if ((++cancelPolls & 15) != 0)
+        return;
+
+    if (gTimeLimit > 0 && clock() > deadline)
+        LogMsg(LOGERROR, CANCELERROR, "Hinting %s took too long.\n",
+               gGlyphName);
+    if (gCancelCB != NULL && gCancelCB())
+        LogMsg(LOGERROR, CANCELERROR, "Hinting %s was cancelled.\n",
+               gGlyphName);
+}
+
 /* Returns whether coloring was successful. */
 bool
 AutoColor(const ACFontInfo* fontinfo, const char* srcbezdata, bool fixStems,
-          bool debug, bool extracolor, bool changeChar, bool roundCoords)
+          bool debug, bool extracolor, bool changeChar, bool roundCoords,
+          bool draft)
 {
+    StartTimeLimit();
+    ArmMemoryLimit(true);
     InitAll(fontinfo, STARTUP);
 
     if (!ReadFontInfo(fontinfo))
@@ -159,6 +207,7 @@ AutoColor(const ACFontInfo* fontinfo, const char* srcbezdata, bool fixStems,
 
     gEditChar = changeChar;
     gRoundToInt = roundCoords;
+    gDraftMode = draft;
     gAutoLinearCurveFix = gEditChar;
     if (gEditChar && fixStems)
         gAutoVFix = gAutoHFix = fixStems;
@@ -149,9 +149,16 @@ typedef struct _pthelt {
   int16_t type;
   PSegLnkLst Hs, Vs;
   bool Hcopy:1, Vcopy:1, isFlex:1, yFlex:1, newCP:1, sol:1, eol:1;
-  int unused:9;
+  bool tiny:1, endsSet:1, nxtBendSet:1, prvBendSet:1;
+  int unused:5;
   int16_t count, newcolors;
   Fixed x, y, x1, y1, x2, y2, x3, y3;
+  Fixed ex0, ey0, ex1, ey1;
+    /* end points and tiny flag as given by GetEndPoints and IsTiny */
+  struct _pthelt *nxtBend, *prvBend;
+  Fixed nxtBx2, nxtBy2, nxtBx3, nxtBy3, prvBx2, prvBy2;
+    /* what NxtForBend and PrvForBend give */
+    /* kept by gen.c on first use, and cleared for each pass and on edits */
   } PathElt, *PPathElt;
 
 typedef struct _clrpnt {
@@ -163,14 +170,13 @@ typedef struct _clrpnt {
     /* p0 is source of x0,y0; p1 is source of x1,y1 */
   char c;
     /* tells what kind of coloring: 'b' 'y' 'm' or 'v' */
-  bool done;
   } ClrPoint, *PClrPoint;
 
 typedef struct {
 	char *key, *value;
 } FFEntry;
 
-typedef struct {
+typedef struct _acfontinfo {
   FFEntry *entries; /* font information entries */
   size_t length;    /* number of the entries */
 } ACFontInfo;
@@ -188,6 +194,7 @@ extern bool gYgoesUp;
 extern bool gUseV, gUseH, gAutoVFix, gAutoHFix, gAutoLinearCurveFix;
 extern bool gAutoExtraDebug, gDebugColorPath, gDebug, gLogging;
 extern bool gEditChar; /* whether character can be modified when adding hints */
+extern bool gDraftMode; /* whether to skip the hint refinement passes */
 extern bool gShowHs, gShowVs, gBandError, gListClrInfo;
 extern bool gReportErrors, gHasFlex, gFlexOK, gFlexStrict, gShowClrInfo;
 extern Fixed gHBigDist, gVBigDist, gInitBigDist, gMinDist, gGhostWidth,
@@ -222,6 +229,13 @@ void AddStemExtremes(Fixed bot, Fixed top);
 
 extern AC_RETRYPTR gReportRetryCB;
 
+/* processor time allowed for hinting one glyph in seconds, 0 if unlimited */
+extern double gTimeLimit;
+extern AC_CANCELPTR gCancelCB;
+
+void StartTimeLimit(void);
+void CheckCancel(void);
+
 #define leftList (gSegLists[0])
 #define rightList (gSegLists[1])
 #define topList (gSegLists[2])
@@ -311,6 +325,7 @@ bool SpecialSolEol(void);
 bool MoveToNewClrs(void);
 void CheckSmooth(void);
 void CheckBBoxEdge(PPathElt e, bool vrt, Fixed lc, Fixed* pf, Fixed* pl);
+Fixed ATan(Fixed a, Fixed b);
 bool CheckSmoothness(Fixed x0, Fixed cy0, Fixed x1, Fixed cy1, Fixed x2,
                      Fixed y2, Fixed* pd);
 void CheckForDups(void);
@@ -453,10 +468,19 @@ void InitAll(const ACFontInfo* fontinfo, int32_t reason);
 void AddVStem(Fixed top, Fixed bottom, bool curved);
 void AddHStem(Fixed right, Fixed left, bool curved);
 
+/* stem and zone histograms for AC_GetStemHistograms() and
+ * AC_DeriveFontInfo() */
+extern bool gDoStemHists, gDoZoneHists;
+void InitReportHists(bool mergeCurvedStems);
+void DiscardGlyphReports(void);
+void CommitGlyphReports(void);
+bool FinishStemHists(AC_StemHistograms* histograms);
+size_t FormatDerivedFontInfo(int unitsPerEm, char* buf, size_t size);
+
 void AddCharExtremes(Fixed bot, Fixed top);
 
 bool AutoColor(const ACFontInfo* fontinfo, const char* srcbezdata,
                bool fixStems, bool debug, bool extracolor, bool changeChar,
-               bool roundCoords);
+               bool roundCoords, bool draft);
 
 #endif /* AC_AC_H_ */
@@ -548,21 +548,16 @@ CheckElmntClrSegs(void)
 static bool
 ClrLstsClash(PSegLnkLst lst1, PSegLnkLst lst2, bool flg)
 {
+    /* TestColorLst checks val against all of lst2, not only its head */
     PClrSeg seg;
     PClrVal val;
-    PSegLnkLst lst;
+    if (lst2 == NULL)
+        return false;
     while (lst1 != NULL) {
         seg = lst1->lnk->seg;
         val = seg->sLnk;
-        if (val != NULL) {
-            lst = lst2;
-            while (lst != NULL) {
-                if (TestColorLst(lst, val, flg, false) == 0) {
-                    return true;
-                }
-                lst = lst->next;
-            }
-        }
+        if (val != NULL && TestColorLst(lst2, val, flg, false) == 0)
+            return true;
         lst1 = lst1->next;
     }
     return false;
@@ -1110,6 +1105,7 @@ AutoExtraColors(bool movetoNewClrs, bool soleol, int32_t solWhere)
         PrintMessage("color loop");
     mtVclrs = mtHclrs = NULL;
     while (e != NULL) {
+        CheckCancel();
         etype = e->type;
         if (movetoNewClrs && etype == MOVETO) {
             StartNewColoring(e, (PSegLnkLst)NULL, (PSegLnkLst)NULL);
@@ -11,12 +11,14 @@
    from AC.  It should not contain calls to procedures implemented
    in object files that are not bound into AC. */
 
+#include <math.h>
+
 #include "charpath.h"
 #include "memory.h"
+#include "opcodes.h"
 
 #define MAXPATHELT 100 /* initial maximum number of path elements */
 
-static int32_t maxPathEntries = 0;
 static PPathList currPathList = NULL;
 int32_t path_entries;
 bool addHints = true;
@@ -28,19 +30,20 @@ CheckPath(void)
 {
 
     if (currPathList->path == NULL) {
+        currPathList->capacity = MAXPATHELT;
         currPathList->path = (CharPathElt*)AllocateMem(
-          maxPathEntries, sizeof(CharPathElt), "path element array");
+          currPathList->capacity, sizeof(CharPathElt), "path element array");
     }
-    if (path_entries >= maxPathEntries) {
+    if (path_entries >= currPathList->capacity) {
         int i;
 
-        maxPathEntries += MAXPATHELT;
+        currPathList->capacity += MAXPATHELT;
         currPathList->path = (PCharPathElt)ReallocateMem(
-          (char*)currPathList->path, maxPathEntries * sizeof(CharPathElt),
-          "path element array");
+          (char*)currPathList->path,
+          currPathList->capacity * sizeof(CharPathElt), "path element array");
         /* Initialize certain fields in CharPathElt, since realloc'ed memory */
         /* may be non-zero. */
-        for (i = path_entries; i < maxPathEntries; i++) {
+        for (i = path_entries; i < currPathList->capacity; i++) {
             currPathList->path[i].hints = NULL;
             currPathList->path[i].isFlex = false;
             currPathList->path[i].sol = false;
@@ -50,6 +53,41 @@ CheckPath(void)
     }
 }
 
+/* Makes plist the path list that ReadGlyph fills when reading a glyph for
+   blended data. */
+void
+SetCharPathList(PPathList plist)
+{
+    memset(plist, 0, sizeof(PathList));
+    currPathList = plist;
+    path_entries = 0;
+    addHints = true;
+}
+
+static void
+FreeHintElts(PHintElt hints)
+{
+    while (hints != NULL) {
+        PHintElt next = hints->next;
+        UnallocateMem(hints);
+        hints = next;
+    }
+}
+
+void
+FreeCharPathList(PPathList plist)
+{
+    int32_t i;
+
+    FreeHintElts(plist->mainhints);
+    if (plist->path != NULL) {
+        for (i = 0; i < plist->capacity; i++)
+            FreeHintElts(plist->path[i].hints);
+        UnallocateMem(plist->path);
+    }
+    memset(plist, 0, sizeof(PathList));
+}
+
 PCharPathElt
 AppendCharPathElement(int pathtype)
 {
@@ -57,6 +95,7 @@ AppendCharPathElement(int pathtype)
     CheckPath();
     currPathList->path[path_entries].type = pathtype;
     path_entries++;
+    currPathList->count = path_entries;
     return (&currPathList->path[path_entries - 1]);
 }
 
@@ -112,3 +151,174 @@ char *locktype;
     currPathList[path_entries-1].eol = true;
 }
 */
+
+/* Whether two masters have the same path elements. */
+bool
+CompatibleCharPaths(PPathList plist1, PPathList plist2)
+{
+    int32_t i;
+
+    if (plist1->count != plist2->count)
+        return false;
+    for (i = 0; i < plist1->count; i++) {
+        if (plist1->path[i].type != plist2->path[i].type)
+            return false;
+    }
+    return true;
+}
+
+static void
+GetCharPathEnd(PPathList plist, int32_t ix, Cd* c)
+{
+    PCharPathElt e = &plist->path[ix];
+
+    if (e->type == RCT) {
+        c->x = e->x3;
+        c->y = e->y3;
+        return;
+    }
+    if (e->type == CP) { /* back to the start of the subpath */
+        while (ix > 0 && plist->path[ix].type != RMT)
+            ix--;
+        e = &plist->path[ix];
+    }
+    c->x = e->x;
+    c->y = e->y;
+}
+
+/* Gets the x or y coordinates of a path element as a cubic Bezier: lines
+   and closepaths have their control points at their ends, and movetos all
+   their points at the same place. */
+static void
+GetEltBezier(PPathList plist, int32_t ix, bool isX, double* b)
+{
+    PCharPathElt e = &plist->path[ix];
+    Cd start, end;
+
+    GetCharPathEnd(plist, ix, &end);
+    if (ix > 0 && e->type != RMT)
+        GetCharPathEnd(plist, ix - 1, &start);
+    else
+        start = end;
+    b[0] = FixToDbl(isX ? start.x : start.y);
+    b[3] = FixToDbl(isX ? end.x : end.y);
+    if (e->type == RCT) {
+        b[1] = FixToDbl(isX ? e->x1 : e->y1);
+        b[2] = FixToDbl(isX ? e->x2 : e->y2);
+    } else {
+        b[1] = b[0];
+        b[2] = b[3];
+    }
+}
+
+static double
+BezierAt(const double* b, double t)
+{
+    double mt = 1 - t;
+    return mt * mt * mt * b[0] + 3 * mt * mt * t * b[1] +
+           3 * mt * t * t * b[2] + t * t * t * b[3];
+}
+
+#define MAPSTEPS 32
+
+/* Returns where the hint edge at value in master0, which comes from the path
+   element ix, is in master: at the same point of the element, or at the same
+   position along it when the edge is not at one of its points, such as at
+   the extreme of a curve. */
+static Fixed
+MapHintEdge(PPathList master0, PPathList master, int32_t ix, bool isX,
+            Fixed value)
+{
+    static const int points[] = { 3, 0, 1, 2 };
+    double b0[4], b[4], v = FixToDbl(value), dist, bestDist, t, bestT, lo, hi;
+    double mapped;
+    int i, bestPt = 3;
+
+    GetEltBezier(master0, ix, isX, b0);
+    GetEltBezier(master, ix, isX, b);
+
+    bestDist = fabs(b0[3] - v);
+    for (i = 1; i < 4; i++) {
+        dist = fabs(b0[points[i]] - v);
+        if (dist < bestDist) {
+            bestDist = dist;
+            bestPt = points[i];
+        }
+    }
+    mapped = b[bestPt] + (v - b0[bestPt]);
+
+    if (bestDist > 0 && master0->path[ix].type != RMT) {
+        bestT = 0;
+        for (i = 0; i <= MAPSTEPS; i++) {
+            t = (double)i / MAPSTEPS;
+            dist = fabs(BezierAt(b0, t) - v);
+            if (dist < fabs(BezierAt(b0, bestT) - v))
+                bestT = t;
+        }
+        /* Narrow down to the closest position around the best step. */
+        lo = NUMMAX(bestT - 1.0 / MAPSTEPS, 0);
+        hi = NUMMIN(bestT + 1.0 / MAPSTEPS, 1);
+        for (i = 0; i < 40; i++) {
+            double t1 = lo + (hi - lo) / 3, t2 = hi - (hi - lo) / 3;
+            if (fabs(BezierAt(b0, t1) - v) < fabs(BezierAt(b0, t2) - v))
+                hi = t2;
+            else
+                lo = t1;
+        }
+        t = (lo + hi) / 2;
+        if (fabs(BezierAt(b0, t) - v) < bestDist)
+            mapped = BezierAt(b, t) + (v - BezierAt(b0, t));
+    }
+    return (Fixed)floor(mapped * FixOne + 0.5);
+}
+
+/* Replaces *mapped with the hints moved to master. Each hint is linked in as
+ * soon as it is allocated, so that all of them are freed with master if an
+ * allocation fails. */
+static void
+MapHintElts(PPathList master0, PPathList master, PHintElt hints,
+            PHintElt* mapped)
+{
+    FreeHintElts(*mapped);
+    *mapped = NULL;
+
+    for (; hints != NULL; hints = hints->next) {
+        PHintElt h;
+        bool isX = (hints->type == RY || hints->type == RM + ESCVAL);
+        bool hasLo = hints->pathix1 > 0 && hints->pathix1 <= master0->count;
+        bool hasHi = hints->pathix2 > 0 && hints->pathix2 <= master0->count;
+        Fixed lo = hints->leftorbot, hi = hints->rightortop;
+
+        /* Ghost hints only come from one element, and keep their width. */
+        if (hasLo)
+            lo = MapHintEdge(master0, master, hints->pathix1 - 1, isX, lo);
+        if (hasHi)
+            hi = MapHintEdge(master0, master, hints->pathix2 - 1, isX, hi);
+        if (hasLo && !hasHi)
+            hi = lo + (hints->rightortop - hints->leftorbot);
+        else if (hasHi && !hasLo)
+            lo = hi - (hints->rightortop - hints->leftorbot);
+
+        h = (PHintElt)AllocateMem(1, sizeof(HintElt), "hint element");
+        h->type = hints->type;
+        h->leftorbot = lo;
+        h->rightortop = hi;
+        h->pathix1 = hints->pathix1;
+        h->pathix2 = hints->pathix2;
+        *mapped = h;
+        mapped = &h->next;
+    }
+}
+
+/* Gives master, which must be compatible with master0, the hints of master0,
+   moved to where the path elements they come from are in master. */
+void
+MapCharPathHints(PPathList master0, PPathList master)
+{
+    int32_t i;
+
+    MapHintElts(master0, master, master0->mainhints, &master->mainhints);
+    for (i = 0; i < master0->count; i++)
+        MapHintElts(master0, master, master0->path[i].hints,
+                    &master->path[i].hints);
+}
@@ -34,8 +34,13 @@ typedef struct _t_pathlist {
   PHintElt mainhints;
   int32_t sb;
   int16_t width;
+  int32_t count;    /* number of path elements */
+  int32_t capacity; /* allocated path elements */
 } PathList, *PPathList;
 
+/* Added to RM and RV to tell them from RB and RY in HintElt.type. */
+#define ESCVAL 100
+
 extern int32_t path_entries;  /* number of elements in a character path */
 extern bool addHints;  /* whether to include hints in the font */
 
@@ -45,5 +50,15 @@ void SetHintsElt(int16_t, CdPtr, int32_t, int32_t, bool);
 
 void SetNoHints(void);
 
+void SetCharPathList(PPathList plist);
+
+void FreeCharPathList(PPathList plist);
+
+bool CompatibleCharPaths(PPathList plist1, PPathList plist2);
+
+void MapCharPathHints(PPathList master0, PPathList master);
+
+void SaveCharPath(PPathList plist);
+
 #endif /*CHARPATH_H*/
 
@@ -523,10 +523,15 @@ MakeColinear(Fixed tx, Fixed ty, Fixed x0, Fixed cy0, Fixed x1, Fixed cy1,
 }
 
 #define DEG(x) ((x)*57.29577951308232088)
-static Fixed
+Fixed
 ATan(Fixed a, Fixed b)
 {
     float aa, bb, cc;
+    /* atan2 gives these exactly, and they are the most common */
+    if (a == 0)
+        return (b > 0) ? 0 : FixInt(180);
+    if (b == 0)
+        return (a > 0) ? FixInt(90) : FixInt(270);
     acfixtopflt(a, &aa);
     acfixtopflt(b, &bb);
     cc = (float)DEG(atan2((double)aa, (double)bb));
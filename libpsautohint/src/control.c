@@ -119,12 +119,43 @@ PointListCheck(PClrPoint new, PClrPoint lst)
     }
 }
 
+static uint32_t
+PtLstHash(PClrPoint lst)
+{
+    /* the same for lists holding the same hints in any order */
+    uint32_t hash = 0, h;
+    Fixed l1, l2, tmp;
+    while (lst != NULL) {
+        if (lst->c == 'y' || lst->c == 'm') {
+            l1 = lst->x0;
+            l2 = lst->x1;
+        } else {
+            l1 = lst->y0;
+            l2 = lst->y1;
+        }
+        if (l1 > l2) {
+            tmp = l1;
+            l1 = l2;
+            l2 = tmp;
+        }
+        h = ((uint32_t)lst->c * 31 + (uint32_t)l1) * 31 + (uint32_t)l2;
+        h *= 2654435761u;
+        hash += h ^ (h >> 15);
+        lst = lst->next;
+    }
+    return hash;
+}
+
 static bool
 SameColorLists(PClrPoint lst1, PClrPoint lst2)
 {
     if (PtLstLen(lst1) != PtLstLen(lst2)) {
         return false;
     }
+    /* tells most different lists apart without comparing every pair */
+    if (PtLstHash(lst1) != PtLstHash(lst2)) {
+        return false;
+    }
     while (lst1 != NULL) { /* go through lst1 */
         if (PointListCheck(lst1, lst2) != 1) {
             return false;
@@ -173,7 +204,6 @@ AddColorPoint(Fixed x0, Fixed y0, Fixed x1, Fixed y1, char ch, PPathElt p0,
     pt->x1 = x1;
     pt->y1 = y1;
     pt->c = ch;
-    pt->done = false;
     pt->next = NULL;
     pt->p0 = p0;
     pt->p1 = p1;
@@ -345,14 +375,14 @@ UseCounter(PClrVal sLst, bool mclr)
 static void
 GetNewPtLst(void)
 {
-    if (gNumPtLsts >= gMaxPtLsts) { /* increase size */
+    if (gNumPtLsts >= gMaxPtLsts) { /* double the size */
         PClrPoint* newArray;
         int32_t i;
-        gMaxPtLsts += 5;
-        newArray = (PClrPoint*)Alloc(gMaxPtLsts * sizeof(PClrPoint));
-        for (i = 0; i < gMaxPtLsts - 5; i++) {
+        newArray = (PClrPoint*)Alloc(2 * gMaxPtLsts * sizeof(PClrPoint));
+        for (i = 0; i < gMaxPtLsts; i++) {
             newArray[i] = gPtLstArray[i];
         }
+        gMaxPtLsts *= 2;
         gPtLstArray = newArray;
     }
     gPtLstIndex = gNumPtLsts;
@@ -817,6 +847,7 @@ AddColorsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
     int32_t solEolCode = 2, retryColoring = 0;
     bool isSolEol = false;
     while (true) {
+        CheckCancel();
         PreGenPts();
         CheckSmooth();
         InitShuffleSubpaths();
@@ -824,7 +855,7 @@ AddColorsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
         if (!gDoAligns) {
             Yellows();
         }
-        if (gEditChar) {
+        if (gEditChar && !gDraftMode) {
             DoShuffleSubpaths();
         }
         gHPrimary = CopyClrs(gHColoring);
@@ -837,11 +868,12 @@ AddColorsInnerLoop(const ACFontInfo* fontinfo, const char* srcglyph,
         if (gListClrInfo) {
             ListClrInfo();
         }
-        if (extracolor) {
+        if (extracolor && !gDraftMode) {
             AutoExtraColors(MoveToNewClrs(), isSolEol, solEolCode);
         }
         gPtLstArray[gPtLstIndex] = gPointList;
-        if (isSolEol) {
+        /* draft hints are made in a single pass, without the fixes */
+        if (isSolEol || gDraftMode) {
             break;
         }
         retryColoring++;
@@ -923,7 +955,7 @@ AddColors(const ACFontInfo* fontinfo, const char* srcglyph, bool extracolor)
     if (!PreCheckForColoring()) {
         return;
     }
-    if (gFlexOK) {
+    if (gFlexOK && !gDraftMode) {
         gHasFlex = false;
         AutoAddFlex();
     }
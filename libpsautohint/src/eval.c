@@ -523,6 +523,7 @@ EvalV(void)
     gValList = NULL;
     lList = leftList;
     while (lList != NULL) {
+        CheckCancel();
         rList = rightList;
         while (rList != NULL) {
             lft = lList->sLoc;
@@ -548,6 +549,7 @@ EvalH(void)
     gValList = NULL;
     bList = botList;
     while (bList != NULL) {
+        CheckCancel();
         tList = topList;
         while (tList != NULL) {
             Fixed bot, top;
@@ -31,10 +31,9 @@ GetKeyValue(const ACFontInfo* fontinfo, char* keyword, bool optional,
 
     fontinfostr = GetFontInfo(fontinfo, keyword, optional);
 
-    if ((fontinfostr != NULL) && (fontinfostr[0] != 0)) {
+    if ((fontinfostr != NULL) && (fontinfostr[0] != 0))
         *value = atol(fontinfostr);
-        UnallocateMem(fontinfostr);
-    }
+    UnallocateMem(fontinfostr);
     return;
 }
 
@@ -50,8 +49,8 @@ GetKeyFixedValue(const ACFontInfo* fontinfo, char* keyword, bool optional,
     if ((fontinfostr != NULL) && (fontinfostr[0] != 0)) {
         sscanf(fontinfostr, "%g", &tempValue);
         *value = (Fixed)tempValue * (1 << FixShift);
-        UnallocateMem(fontinfostr);
     }
+    UnallocateMem(fontinfostr);
     return;
 }
 
@@ -303,8 +302,10 @@ ParseIntStems(const ACFontInfo* fontinfo, char* kw, bool optional,
     else
         initline = GetFontInfo(fontinfo, kw, optional);
 
-    if (initline == NULL || strlen(initline) == 0)
+    if (initline == NULL || strlen(initline) == 0) {
+        UnallocateMem(initline);
         return; /* optional keyword not found */
+    }
 
     line = initline;
 
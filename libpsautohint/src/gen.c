@@ -204,6 +204,57 @@ IsCCW(Fixed x0, Fixed y0, Fixed x1, Fixed y1, Fixed x2, Fixed y2)
     return ccw;
 }
 
+/* The generators ask for the end points and the bend neighbours of most
+ * elements more than once, so they are looked up once per pass and kept on
+ * the element. Whatever changes the path after PreGenPts must call
+ * ForgetEltEnds, as the generators do when ReportLinearCurve turns a curve
+ * into a line. */
+static void
+ForgetEltEnds(void)
+{
+    PPathElt e;
+    for (e = gPathStart; e != NULL; e = e->next)
+        e->endsSet = e->nxtBendSet = e->prvBendSet = false;
+}
+
+static void
+GetEltEnds(PPathElt p)
+{
+    if (!p->endsSet) {
+        GetEndPoints(p, &p->ex0, &p->ey0, &p->ex1, &p->ey1);
+        p->tiny =
+          abs(p->ex0 - p->ex1) < FixTwo && abs(p->ey0 - p->ey1) < FixTwo;
+        p->endsSet = true;
+    }
+}
+
+static PPathElt
+BendNxt(PPathElt p, Fixed* px2, Fixed* py2, Fixed* px3, Fixed* py3)
+{
+    if (!p->nxtBendSet) {
+        p->nxtBend =
+          NxtForBend(p, &p->nxtBx2, &p->nxtBy2, &p->nxtBx3, &p->nxtBy3);
+        p->nxtBendSet = true;
+    }
+    *px2 = p->nxtBx2;
+    *py2 = p->nxtBy2;
+    *px3 = p->nxtBx3;
+    *py3 = p->nxtBy3;
+    return p->nxtBend;
+}
+
+static PPathElt
+BendPrv(PPathElt p, Fixed* px2, Fixed* py2)
+{
+    if (!p->prvBendSet) {
+        p->prvBend = PrvForBend(p, &p->prvBx2, &p->prvBy2);
+        p->prvBendSet = true;
+    }
+    *px2 = p->prvBx2;
+    *py2 = p->prvBy2;
+    return p->prvBend;
+}
+
 static void
 DoHBendsNxt(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
 {
@@ -211,7 +262,7 @@ DoHBendsNxt(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
     bool ysame, ccw, above, doboth;
     if (y0 == y1)
         return;
-    (void)NxtForBend(p, &x2, &y2, &x3, &y3);
+    (void)BendNxt(p, &x2, &y2, &x3, &y3);
     ysame = ProdLt0(y2 - y1, y1 - y0); /* y0 and y2 on same side of y1 */
     if (ysame ||
         (TestTan(x1 - x2, y1 - y2) &&
@@ -246,7 +297,7 @@ DoHBendsPrv(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
     bool ysame, ccw, above, doboth;
     if (y0 == y1)
         return;
-    (void)PrvForBend(p, &x2, &y2);
+    (void)BendPrv(p, &x2, &y2);
     ysame = ProdLt0(y2 - y0, y0 - y1);
     if (ysame ||
         (TestTan(x0 - x2, y0 - y2) &&
@@ -280,7 +331,7 @@ DoVBendsNxt(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
     bool xsame, ccw, right, doboth;
     if (x0 == x1)
         return;
-    (void)NxtForBend(p, &x2, &y2, &x3, &y3);
+    (void)BendNxt(p, &x2, &y2, &x3, &y3);
     xsame = ProdLt0(x2 - x1, x1 - x0);
     if (xsame ||
         (TestTan(y1 - y2, x1 - x2) &&
@@ -315,7 +366,7 @@ DoVBendsPrv(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
     bool xsame, ccw, right, doboth;
     if (x0 == x1)
         return;
-    (void)PrvForBend(p, &x2, &y2);
+    (void)BendPrv(p, &x2, &y2);
     xsame = ProdLt0(x2 - x0, x0 - x1);
     if (xsame ||
         (TestTan(y0 - y2, x0 - x2) &&
@@ -567,7 +618,7 @@ static bool
 NxtHorz(Fixed x, Fixed y, PPathElt p)
 {
     Fixed x2, y2, x3, y3;
-    p = NxtForBend(p, &x2, &y2, &x3, &y3);
+    p = BendNxt(p, &x2, &y2, &x3, &y3);
     return TstFlat(y2 - y, x2 - x);
 }
 
@@ -575,7 +626,7 @@ static bool
 PrvHorz(Fixed x, Fixed y, PPathElt p)
 {
     Fixed x2, y2;
-    p = PrvForBend(p, &x2, &y2);
+    p = BendPrv(p, &x2, &y2);
     return TstFlat(y2 - y, x2 - x);
 }
 
@@ -583,7 +634,7 @@ static bool
 NxtVert(Fixed x, Fixed y, PPathElt p)
 {
     Fixed x2, y2, x3, y3;
-    p = NxtForBend(p, &x2, &y2, &x3, &y3);
+    p = BendNxt(p, &x2, &y2, &x3, &y3);
     return TstFlat(x2 - x, y2 - y);
 }
 
@@ -591,7 +642,7 @@ static bool
 PrvVert(Fixed x, Fixed y, PPathElt p)
 {
     Fixed x2, y2;
-    p = PrvForBend(p, &x2, &y2);
+    p = BendPrv(p, &x2, &y2);
     return TstFlat(x2 - x, y2 - y);
 }
 
@@ -610,7 +661,7 @@ static bool
 PrvSameDir(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
 {
     Fixed x2, y2;
-    p = PrvForBend(p, &x2, &y2);
+    p = BendPrv(p, &x2, &y2);
     if (p != NULL && p->type == CURVETO && p->prev != NULL)
         GetEndPoint(p->prev, &x2, &y2);
     return TstSameDir(x0, y0, x1, y1, x2, y2);
@@ -620,7 +671,7 @@ static bool
 NxtSameDir(Fixed x0, Fixed y0, Fixed x1, Fixed y1, PPathElt p)
 {
     Fixed x2, y2, x3, y3;
-    p = NxtForBend(p, &x2, &y2, &x3, &y3);
+    p = BendNxt(p, &x2, &y2, &x3, &y3);
     if (p != NULL && p->type == CURVETO) {
         x2 = p->x3;
         y2 = p->y3;
@@ -644,7 +695,11 @@ GenVPts(int32_t specialCharType)
     fl = NULL;
     while (p != NULL) {
         Fixed x0, y0, x1, y1;
-        GetEndPoints(p, &x0, &y0, &x1, &y1);
+        GetEltEnds(p);
+        x0 = p->ex0;
+        y0 = p->ey0;
+        x1 = p->ex1;
+        y1 = p->ey1;
         if (p->type == CURVETO) {
             Fixed px1, py1, px2, py2;
             isVert = false;
@@ -705,12 +760,14 @@ GenVPts(int32_t specialCharType)
                     q2 = VertQuo(x0, y0, x1, y1);
                     yd2 = (q2 > 0) ? AdjDist(y1 - y0, q2) : 0;
                     if (isVert && q2 > 0 && abs(yd2) > abs(ydist)) {
-                        if (x0 == px1 && px1 == px2 && px2 == x1)
+                        if (x0 == px1 && px1 == px2 && px2 == x1) {
                             ReportLinearCurve(p, x0, y0, x1, y1);
+                            ForgetEltEnds();
+                        }
                         ydist = FixHalfMul(yd2);
                         yavg = FixHalfMul(y0 + y1);
-                        (void)PrvForBend(p, &prvx, &prvy);
-                        (void)NxtForBend(p, &nxtx, &nxty, &xx, &yy);
+                        (void)BendPrv(p, &prvx, &prvy);
+                        (void)BendNxt(p, &nxtx, &nxty, &xx, &yy);
                         AddVSegment(yavg - ydist, yavg + ydist,
                                     PickVSpot(x0, y0, x1, y1, px1, py1, px2,
                                               py2, prvx, prvy, nxtx, nxty),
@@ -762,7 +819,7 @@ GenVPts(int32_t specialCharType)
                 if (IsUpper(p))
                     gBonus = FixInt(200);
             }
-        } else if (!IsTiny(p)) {
+        } else if (!p->tiny) {
             if ((q = VertQuo(x0, y0, x1, y1)) > 0) {
                 if (x0 == x1)
                     AddVSegment(y0, y1, x0, p->prev, p, sLINE, 11);
@@ -771,8 +828,8 @@ GenVPts(int32_t specialCharType)
                         q = FixQuarter;
                     ydist = FixHalfMul(AdjDist(y1 - y0, q));
                     yavg = FixHalfMul(y0 + y1);
-                    (void)PrvForBend(p, &prvx, &prvy);
-                    (void)NxtForBend(p, &nxtx, &nxty, &xx, &yy);
+                    (void)BendPrv(p, &prvx, &prvy);
+                    (void)BendNxt(p, &nxtx, &nxty, &xx, &yy);
                     AddVSegment(yavg - ydist, yavg + ydist,
                                 PickVSpot(x0, y0, x1, y1, x0, y0, x1, y1, prvx,
                                           prvy, nxtx, nxty),
@@ -881,7 +938,11 @@ GenHPts(void)
     cpFrom = 100 - cpTo;
     while (p != NULL) {
         Fixed x0, y0, x1, y1;
-        GetEndPoints(p, &x0, &y0, &x1, &y1);
+        GetEltEnds(p);
+        x0 = p->ex0;
+        y0 = p->ey0;
+        x1 = p->ex1;
+        y1 = p->ey1;
         if (p->type == CURVETO) {
             Fixed px1, py1, px2, py2;
             isHoriz = false;
@@ -941,10 +1002,12 @@ GenHPts(void)
                     xd2 = (q2 > 0) ? AdjDist(x1 - x0, q2) : 0;
                     if (isHoriz && q2 > 0 && abs(xd2) > abs(xdist)) {
                         Fixed hspot;
-                        if (y0 == py1 && py1 == py2 && py2 == y1)
+                        if (y0 == py1 && py1 == py2 && py2 == y1) {
                             ReportLinearCurve(p, x0, y0, x1, y1);
-                        (void)PrvForBend(p, &prvx, &prvy);
-                        (void)NxtForBend(p, &nxtx, &nxty, &xx, &yy);
+                            ForgetEltEnds();
+                        }
+                        (void)BendPrv(p, &prvx, &prvy);
+                        (void)BendNxt(p, &nxtx, &nxty, &xx, &yy);
                         xdist = FixHalfMul(xd2);
                         xavg = FixHalfMul(x0 + x1);
                         hspot = PickHSpot(x0, y0, x1, y1, xdist, px1, py1, px2,
@@ -989,7 +1052,7 @@ GenHPts(void)
                     }
                 }
             }
-        } else if (p->type != MOVETO && !IsTiny(p)) {
+        } else if (p->type != MOVETO && !p->tiny) {
             if ((q = HorzQuo(x0, y0, x1, y1)) > 0) {
                 if (y0 == y1)
                     AddHSegment(x0, x1, y0, p->prev, p, sLINE, 11);
@@ -998,8 +1061,8 @@ GenHPts(void)
                         q = FixQuarter;
                     xdist = FixHalfMul(AdjDist(x1 - x0, q));
                     xavg = FixHalfMul(x0 + x1);
-                    (void)PrvForBend(p, &prvx, &prvy);
-                    (void)NxtForBend(p, &nxtx, &nxty, &xx, &yy);
+                    (void)BendPrv(p, &prvx, &prvy);
+                    (void)BendNxt(p, &nxtx, &nxty, &xx, &yy);
                     yy = PickHSpot(x0, y0, x1, y1, xdist, x0, y0, x1, y1, prvx,
                                    prvy, nxtx, nxty);
                     AddHSegment(xavg - xdist, xavg + xdist, yy, p->prev, p,
@@ -1031,4 +1094,5 @@ PreGenPts(void)
     gSegLists[1] = NULL;
     gSegLists[2] = NULL;
     gSegLists[3] = NULL;
+    ForgetEltEnds();
 }
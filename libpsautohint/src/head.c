@@ -106,6 +106,12 @@ HVness(float* pq)
     return acpflttofix(&result);
 }
 
+/* HVness is 0 from q = 4 on, and q is at least 4.1 when this is true, as long
+ * as gTheta is no more than the .38 that InitData sets. Most of the deltas
+ * that are far from vertical (or horizontal) are told apart by it without
+ * going through floats. */
+#define QuoIsZero(a, b) ((int64_t)(a) * (a) >= (int64_t)400 * (b))
+
 Fixed
 VertQuo(Fixed xk, Fixed yk, Fixed xl, Fixed yl)
 {
@@ -121,7 +127,7 @@ VertQuo(Fixed xk, Fixed yk, Fixed xl, Fixed yl)
     yabs = yk - yl;
     if (yabs < 0)
         yabs = -yabs;
-    if (yabs == 0)
+    if (yabs == 0 || QuoIsZero(xabs, yabs))
         return 0;
     acfixtopflt(xabs, &rx);
     acfixtopflt(yabs, &ry);
@@ -145,7 +151,7 @@ HorzQuo(Fixed xk, Fixed yk, Fixed xl, Fixed yl)
     xabs = xk - xl;
     if (xabs < 0)
         xabs = -xabs;
-    if (xabs == 0)
+    if (xabs == 0 || QuoIsZero(yabs, xabs))
         return 0;
     acfixtopflt(xabs, &rx);
     acfixtopflt(yabs, &ry);
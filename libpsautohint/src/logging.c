@@ -99,7 +99,8 @@ LogMsg1(char* str, int16_t level, int16_t code)
             WriteWarnorErr(stderr, str);
             break;
     }
-    if (level == LOGERROR && (code == NONFATALERROR || code == FATALERROR)) {
+    if (level == LOGERROR && (code == NONFATALERROR || code == FATALERROR ||
+                              code == CANCELERROR || code == MEMORYERROR)) {
         (*errorproc)(code);
     }
 }
@@ -16,6 +16,8 @@
 #define OK 0
 #define NONFATALERROR 1
 #define FATALERROR 2
+#define CANCELERROR 3 /* the time limit passed or the caller cancelled */
+#define MEMORYERROR 4 /* out of memory, or over the memory limit */
 
 /* defines for LogMsg level param */
 #define INFO 0
@@ -33,6 +33,24 @@ defaultAC_memmanage(void* ctxptr, void* old, size_t size)
 AC_MEMMANAGEFUNCPTR AC_memmanageFuncPtr = defaultAC_memmanage;
 void* AC_memmanageCtxPtr = NULL;
 
+AC_MemoryStats gMemStats;
+
+/* Every block handed out below starts with its size, so that the bytes in
+ * use are known when it is freed. The union keeps the data after it as
+ * aligned as the memory manager returned the block. */
+typedef union
+{
+    size_t size;
+    double d;
+    void* p;
+} MemHeader;
+
+static size_t memInUse;   /* bytes of all the blocks allocated */
+static size_t statsBase;  /* memInUse when the statistics were started */
+static size_t limitBase;  /* memInUse when the limit was armed */
+static size_t memLimit;   /* 0 if unlimited */
+static bool limitArmed;
+
 void
 setAC_memoryManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func)
 {
@@ -40,39 +58,107 @@ setAC_memoryManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func)
     AC_memmanageCtxPtr = ctxptr;
 }
 
+void
+setAC_memoryLimit(size_t limit)
+{
+    memLimit = limit;
+}
+
+void
+StartMemoryStats(void)
+{
+    memset(&gMemStats, 0, sizeof(gMemStats));
+    statsBase = memInUse;
+}
+
+void
+ArmMemoryLimit(bool armed)
+{
+    limitArmed = armed;
+    limitBase = memInUse;
+}
+
+/* Gives up, by way of the error handler, if growing the memory in use by
+ * size bytes would go over the limit. */
+static void
+CheckMemoryLimit(size_t size, const char* description)
+{
+    size_t used = memInUse > limitBase ? memInUse - limitBase : 0;
+
+    if (!limitArmed || memLimit == 0)
+        return;
+    if (used + size > memLimit) {
+        limitArmed = false;
+        LogMsg(LOGERROR, MEMORYERROR,
+               "Cannot allocate %d bytes of memory for %s: the limit of %lu "
+               "bytes is reached.\n",
+               (int)size, description, (unsigned long)memLimit);
+    }
+}
+
+static void
+CountAllocation(size_t size, size_t oldSize)
+{
+    memInUse += size - oldSize;
+    gMemStats.allocCount++;
+    gMemStats.allocBytes += size;
+    if (memInUse > statsBase && memInUse - statsBase > gMemStats.peakBytes)
+        gMemStats.peakBytes = memInUse - statsBase;
+}
+
 void*
 AllocateMem(size_t nelem, size_t elsize, const char* description)
 {
     /* calloc(nelem, elsize) */
-    void* ptr = AC_memmanageFuncPtr(AC_memmanageCtxPtr, NULL, nelem * elsize);
-    if (NULL != ptr)
-        memset(ptr, 0x0, nelem * elsize);
-
-    if (ptr == NULL) {
-        LogMsg(LOGERROR, NONFATALERROR,
-               "Cannot allocate %d bytes of memory for %s.\n",
-               (int)(nelem * elsize), description);
+    size_t size = nelem * elsize;
+    MemHeader* block;
+
+    CheckMemoryLimit(size, description);
+    block = AC_memmanageFuncPtr(AC_memmanageCtxPtr, NULL,
+                                sizeof(MemHeader) + size);
+    if (block == NULL) {
+        LogMsg(LOGERROR, MEMORYERROR,
+               "Cannot allocate %d bytes of memory for %s.\n", (int)size,
+               description);
+        return NULL;
     }
-    return (ptr);
+    memset(block + 1, 0x0, size);
+    block->size = size;
+    CountAllocation(size, 0);
+    return block + 1;
 }
 
 void*
 ReallocateMem(void* ptr, size_t size, const char* description)
 {
     /* realloc(ptr, size) */
-    void* newptr = AC_memmanageFuncPtr(AC_memmanageCtxPtr, ptr, size);
+    MemHeader* block = ptr ? (MemHeader*)ptr - 1 : NULL;
+    size_t oldSize = block ? block->size : 0;
 
-    if (newptr == NULL) {
-        LogMsg(LOGERROR, NONFATALERROR,
+    if (size > oldSize)
+        CheckMemoryLimit(size - oldSize, description);
+    block = AC_memmanageFuncPtr(AC_memmanageCtxPtr, block,
+                                sizeof(MemHeader) + size);
+    if (block == NULL) {
+        LogMsg(LOGERROR, MEMORYERROR,
                "Cannot allocate %d bytes of memory for %s.\n", (int)size,
                description);
+        return NULL;
     }
-    return (newptr);
+    block->size = size;
+    CountAllocation(size, oldSize);
+    return block + 1;
 }
 
 void
 UnallocateMem(void* ptr)
 {
     /* free(ptr) */
-    AC_memmanageFuncPtr(AC_memmanageCtxPtr, ptr, 0);
+    MemHeader* block;
+
+    if (ptr == NULL)
+        return;
+    block = (MemHeader*)ptr - 1;
+    memInUse -= block->size;
+    AC_memmanageFuncPtr(AC_memmanageCtxPtr, block, 0);
 }
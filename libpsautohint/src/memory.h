@@ -17,7 +17,16 @@
 extern AC_MEMMANAGEFUNCPTR AC_memmanageFuncPtr;
 extern void* AC_memmanageCtxPtr;
 
+/* the statistics since the last call to StartMemoryStats */
+extern AC_MemoryStats gMemStats;
+
 void setAC_memoryManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func);
+void setAC_memoryLimit(size_t limit);
+
+void StartMemoryStats(void);
+/* While armed, allocations beyond the limit, counted from the time it was
+ * armed, fail with a MEMORYERROR. */
+void ArmMemoryLimit(bool armed);
 
 void* AllocateMem(size_t, size_t, const char*);
 void* ReallocateMem(void*, size_t, const char*);
@@ -146,6 +146,7 @@ PruneVVals(void)
     sLst = gValList;
     prndist = PRNDIST;
     while (sLst != NULL) {
+        CheckCancel();
         flg = true;
         otherLft = otherRht = false;
         val = sLst->vVal;
@@ -222,6 +223,7 @@ PruneHVals(void)
     sLst = gValList;
     prndist = PRNDIST;
     while (sLst != NULL) {
+        CheckCancel();
         flg = true;
         otherTop = otherBot = false;
         seg1 = sLst->vSeg1;
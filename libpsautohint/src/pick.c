@@ -19,6 +19,9 @@ InitPick(int32_t reason)
         case STARTUP:
         case RESTART:
             Vrejects = Hrejects = NULL;
+            /* Yellows() is skipped when reporting alignment zones, so
+             * gVColoring would otherwise point at the last glyph's hints. */
+            gHColoring = gVColoring = NULL;
     }
 }
 
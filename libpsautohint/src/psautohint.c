@@ -10,6 +10,7 @@
 #include "setjmp.h"
 
 #include "ac.h"
+#include "charpath.h"
 #include "psautohint.h"
 
 const char* libversion = "1.6.0";
@@ -18,6 +19,8 @@ ACBuffer* bezoutput = NULL;
 
 bool gScalingHints = false;
 
+static bool draftMode = false;
+
 jmp_buf aclibmark; /* to handle exit() calls in the library version*/
 
 #define skipblanks()                                                           \
@@ -243,6 +246,19 @@ AC_SetMemManager(void* ctxptr, AC_MEMMANAGEFUNCPTR func)
     setAC_memoryManager(ctxptr, func);
 }
 
+ACLIB_API void
+AC_SetMemoryLimit(size_t bytes)
+{
+    setAC_memoryLimit(bytes);
+}
+
+ACLIB_API void
+AC_GetMemoryStats(AC_MemoryStats* stats)
+{
+    if (stats)
+        *stats = gMemStats;
+}
+
 ACLIB_API void
 AC_SetReportCB(AC_REPORTFUNCPTR reportCB, int verbose)
 {
@@ -254,6 +270,24 @@ AC_SetReportCB(AC_REPORTFUNCPTR reportCB, int verbose)
     gLibErrorReportCB = reportCB;
 }
 
+ACLIB_API void
+AC_SetTimeLimit(double seconds)
+{
+    gTimeLimit = seconds;
+}
+
+ACLIB_API void
+AC_SetCancelCB(AC_CANCELPTR cancelCB)
+{
+    gCancelCB = cancelCB;
+}
+
+ACLIB_API void
+AC_SetDraftMode(int draft)
+{
+    draftMode = draft;
+}
+
 ACLIB_API void
 AC_SetReportStemsCB(AC_REPORTSTEMPTR hstemCB, AC_REPORTSTEMPTR vstemCB,
                     unsigned int allStems)
@@ -286,11 +320,18 @@ AC_SetReportZonesCB(AC_REPORTZONEPTR charCB, AC_REPORTZONEPTR stemCB)
  * will transfer the control to the point where setjmp() is called below. So
  * effectively whenever LogMsg() is called for an error the execution of the
  * calling function will end and we will return back to AutoColorString().
+ * Running out of time or being cancelled returns -2, running out of memory
+ * -3, other errors -1.
  */
 static int
 error_handler(int16_t code)
 {
-    if (code == FATALERROR || code == NONFATALERROR)
+    ArmMemoryLimit(false);
+    if (code == CANCELERROR)
+        longjmp(aclibmark, -2);
+    else if (code == MEMORYERROR)
+        longjmp(aclibmark, -3);
+    else if (code == FATALERROR || code == NONFATALERROR)
         longjmp(aclibmark, -1);
     else
         longjmp(aclibmark, 1);
@@ -298,19 +339,14 @@ error_handler(int16_t code)
     return 0; /* we don't actually ever get here */
 }
 
-ACLIB_API int
-AutoColorString(const char* srcbezdata, const char* fontinfodata,
-                char* dstbezdata, size_t* length, int allowEdit,
-                int allowHintSub, int roundCoords, int debug)
+/* Hints one glyph with a parsed fontinfo, for AutoColorString and
+ * AutoColorStringFI. */
+static int
+HintGlyph(const char* srcbezdata, const ACFontInfo* fontinfo,
+          char* dstbezdata, size_t* length, int allowEdit, int allowHintSub,
+          int roundCoords, int debug)
 {
     int value, result;
-    ACFontInfo* fontinfo = NULL;
-
-    if (!srcbezdata)
-        return AC_InvalidParameterError;
-
-    if (ParseFontInfo(fontinfodata, &fontinfo))
-        return AC_FontinfoParseFail;
 
     set_errorproc(error_handler);
     value = setjmp(aclibmark);
@@ -319,30 +355,32 @@ AutoColorString(const char* srcbezdata, const char* fontinfodata,
      * AutoColor(), or after it finishes execution. See the error_handler
      * comments above and below. */
 
-    if (value == -1) {
+    if (value == -2 || value == -3) {
+        /* the glyph ran out of time or memory, or was cancelled. */
+        FreeBuffer(bezoutput);
+        bezoutput = NULL;
+        return value == -2 ? AC_CancelledError : AC_MemoryError;
+    } else if (value == -1) {
         /* a fatal error occurred somewhere. */
-        FreeFontInfo(fontinfo);
+        FreeBuffer(bezoutput);
+        bezoutput = NULL;
         return AC_FatalError;
     } else if (value == 1) {
         /* AutoColor was called successfully */
-        FreeFontInfo(fontinfo);
+        result = AC_DestBuffOfloError;
         if (bezoutput->length < *length) {
-            *length = bezoutput->length + 1;
-            strncpy(dstbezdata, bezoutput->data, *length);
-            FreeBuffer(bezoutput);
-            return AC_Success;
-        } else {
-            *length = bezoutput->length + 1;
-            FreeBuffer(bezoutput);
-            return AC_DestBuffOfloError;
+            strncpy(dstbezdata, bezoutput->data, bezoutput->length + 1);
+            result = AC_Success;
         }
+        *length = bezoutput->length + 1;
+        FreeBuffer(bezoutput);
+        bezoutput = NULL;
+        return result;
     }
 
     bezoutput = NewBuffer(*length);
-    if (!bezoutput) {
-        FreeFontInfo(fontinfo);
+    if (!bezoutput)
         return AC_MemoryError;
-    }
 
     result = AutoColor(fontinfo,     /* font info */
                        srcbezdata,   /* input glyph */
@@ -350,7 +388,8 @@ AutoColorString(const char* srcbezdata, const char* fontinfodata,
                        debug,        /* debug */
                        allowHintSub, /* extracolor*/
                        allowEdit,    /* editChars */
-                       roundCoords);
+                       roundCoords,  /* roundCoords */
+                       draftMode);   /* draft */
     /* result == true is good */
 
     /* The following call to error_handler() always returns control to just
@@ -362,6 +401,414 @@ AutoColorString(const char* srcbezdata, const char* fontinfodata,
     return AC_UnknownError;
 }
 
+ACLIB_API int
+AutoColorString(const char* srcbezdata, const char* fontinfodata,
+                char* dstbezdata, size_t* length, int allowEdit,
+                int allowHintSub, int roundCoords, int debug)
+{
+    int result;
+    ACFontInfo* fontinfo = NULL;
+
+    if (!srcbezdata)
+        return AC_InvalidParameterError;
+
+    StartMemoryStats();
+    if (ParseFontInfo(fontinfodata, &fontinfo))
+        return AC_FontinfoParseFail;
+
+    result = HintGlyph(srcbezdata, fontinfo, dstbezdata, length, allowEdit,
+                       allowHintSub, roundCoords, debug);
+    FreeFontInfo(fontinfo);
+    return result;
+}
+
+ACLIB_API int
+AC_ParseFontInfo(const char* fontinfodata, AC_FontInfo** fontinfo)
+{
+    if (!fontinfo)
+        return AC_InvalidParameterError;
+    *fontinfo = NULL;
+    if (ParseFontInfo(fontinfodata, fontinfo)) {
+        *fontinfo = NULL;
+        return AC_FontinfoParseFail;
+    }
+    return AC_Success;
+}
+
+ACLIB_API void
+AC_FreeFontInfo(AC_FontInfo* fontinfo)
+{
+    FreeFontInfo(fontinfo);
+}
+
+ACLIB_API int
+AutoColorStringFI(const char* srcbezdata, const AC_FontInfo* fontinfo,
+                  char* dstbezdata, size_t* length, int allowEdit,
+                  int allowHintSub, int roundCoords, int debug)
+{
+    if (!srcbezdata || !fontinfo)
+        return AC_InvalidParameterError;
+
+    StartMemoryStats();
+    return HintGlyph(srcbezdata, fontinfo, dstbezdata, length, allowEdit,
+                     allowHintSub, roundCoords, debug);
+}
+
+/* The masters being hinted together by AutoColorStringMM, kept here so that
+ * they can be released after an error. masterCount is the number of masters
+ * whose path lists have been started. */
+static PathList* masterPaths = NULL;
+static ACBuffer** masterOutputs = NULL;
+static size_t masterCount = 0;
+static bool mastersIncompatible = false;
+
+static void
+FreeMasters(void)
+{
+    size_t i;
+
+    for (i = 0; i < masterCount; i++) {
+        if (masterPaths)
+            FreeCharPathList(&masterPaths[i]);
+        if (masterOutputs)
+            FreeBuffer(masterOutputs[i]);
+    }
+    UnallocateMem(masterPaths);
+    UnallocateMem(masterOutputs);
+    masterPaths = NULL;
+    masterOutputs = NULL;
+    masterCount = 0;
+}
+
+/* Reads the first master, as hinted in bezoutput, and the other masters for
+ * blended data, gives the other masters the hints of the first one and writes
+ * them all to masterOutputs. */
+static void
+HintMasters(const ACFontInfo* fontinfo, const char** srcbezdata,
+            size_t nmasters)
+{
+    size_t i;
+
+    masterPaths = (PathList*)AllocateMem(nmasters, sizeof(PathList),
+                                         "master path lists");
+    masterOutputs = (ACBuffer**)AllocateMem(nmasters, sizeof(ACBuffer*),
+                                            "master out buffers");
+
+    SetCharPathList(&masterPaths[0]);
+    masterCount = 1;
+    ReadGlyph(fontinfo, bezoutput->data, true, true);
+    for (i = 1; i < nmasters; i++) {
+        SetCharPathList(&masterPaths[i]);
+        masterCount = i + 1;
+        ReadGlyph(fontinfo, srcbezdata[i], true, false);
+        if (!CompatibleCharPaths(&masterPaths[0], &masterPaths[i])) {
+            mastersIncompatible = true;
+            LogMsg(LOGERROR, NONFATALERROR,
+                   "Master %d of glyph %s does not have the same path "
+                   "elements as the first master once hinted.\n",
+                   (int)i, gGlyphName);
+        }
+        MapCharPathHints(&masterPaths[0], &masterPaths[i]);
+    }
+
+    FreeBuffer(bezoutput);
+    bezoutput = NULL;
+    for (i = 0; i < nmasters; i++) {
+        masterOutputs[i] = NewBuffer(1024);
+        /* SaveCharPath writes to bezoutput, which is left pointing at this
+         * master's buffer if it fails. */
+        bezoutput = masterOutputs[i];
+        SaveCharPath(&masterPaths[i]);
+    }
+    bezoutput = NULL;
+}
+
+ACLIB_API int
+AutoColorStringMM(const char** srcbezdata, const char* fontinfodata,
+                  size_t nmasters, char** dstbezdata, size_t* lengths,
+                  int allowHintSub, int roundCoords, int debug)
+{
+    int value, result;
+    size_t i;
+    ACFontInfo* fontinfo = NULL;
+
+    if (!srcbezdata || !dstbezdata || !lengths || nmasters == 0)
+        return AC_InvalidParameterError;
+    for (i = 0; i < nmasters; i++) {
+        if (!srcbezdata[i] || !dstbezdata[i])
+            return AC_InvalidParameterError;
+    }
+
+    StartMemoryStats();
+    if (ParseFontInfo(fontinfodata, &fontinfo))
+        return AC_FontinfoParseFail;
+
+    /* Flex would be chosen from the first master alone. */
+    for (i = 0; i < fontinfo->length; i++) {
+        if (!strcmp(fontinfo->entries[i].key, "FlexOK") &&
+            fontinfo->entries[i].value[0]) {
+            UnallocateMem(fontinfo->entries[i].value);
+            fontinfo->entries[i].value = "";
+        }
+    }
+
+    mastersIncompatible = false;
+    set_errorproc(error_handler);
+    value = setjmp(aclibmark);
+
+    if (value < 0) {
+        /* a fatal error occurred somewhere, or the time ran out. bezoutput
+         * is freed here only if it is not a master's buffer. */
+        for (i = 0; masterOutputs && i < masterCount; i++) {
+            if (bezoutput == masterOutputs[i])
+                bezoutput = NULL;
+        }
+        FreeBuffer(bezoutput);
+        bezoutput = NULL;
+        FreeMasters();
+        FreeFontInfo(fontinfo);
+        if (value == -2)
+            return AC_CancelledError;
+        if (value == -3)
+            return AC_MemoryError;
+        return mastersIncompatible ? AC_InvalidParameterError
+                                   : AC_FatalError;
+    } else if (value == 1) {
+        /* AutoColor and HintMasters were called successfully */
+        result = AC_Success;
+        for (i = 0; i < nmasters; i++) {
+            ACBuffer* output = masterOutputs[i];
+            if (output->length < lengths[i])
+                memcpy(dstbezdata[i], output->data, output->length + 1);
+            else
+                result = AC_DestBuffOfloError;
+            lengths[i] = output->length + 1;
+        }
+        FreeMasters();
+        FreeFontInfo(fontinfo);
+        return result;
+    }
+
+    bezoutput = NewBuffer(lengths[0] > 0 ? lengths[0] : 1);
+    if (!bezoutput) {
+        FreeFontInfo(fontinfo);
+        return AC_MemoryError;
+    }
+
+    /* The first master is hinted without changing its path, so that the
+     * hints can be moved to the same path elements in the others. */
+    result = AutoColor(fontinfo, srcbezdata[0], false, debug, allowHintSub,
+                       false, roundCoords, false);
+    if (result)
+        HintMasters(fontinfo, srcbezdata, nmasters);
+
+    error_handler((result == true) ? OK : NONFATALERROR);
+
+    /* Shouldn't get here */
+    return AC_UnknownError;
+}
+
+/* Runs the stem or zone analysis on one glyph, collecting its reports in the
+ * histograms of stemreport.c. */
+static int
+ReportGlyph(const ACFontInfo* fontinfo, const char* srcbezdata)
+{
+    int value;
+    bool result;
+
+    bezoutput->length = 0;
+    bezoutput->data[0] = '\0';
+
+    value = setjmp(aclibmark);
+    if (value < 0) {
+        DiscardGlyphReports();
+        if (value == -2)
+            return AC_CancelledError;
+        return value == -3 ? AC_MemoryError : AC_FatalError;
+    } else if (value == 1) {
+        return AC_Success;
+    }
+
+    result =
+      AutoColor(fontinfo, srcbezdata, false, false, false, false, true, false);
+    if (result)
+        CommitGlyphReports();
+
+    error_handler((result == true) ? OK : NONFATALERROR);
+
+    /* Shouldn't get here */
+    return AC_UnknownError;
+}
+
+ACLIB_API int
+AC_GetStemHistograms(const char* fontinfodata, const char** srcbezdata,
+                     size_t glyphCount, unsigned int allStems,
+                     AC_StemHistograms* histograms)
+{
+    size_t i;
+    int result = AC_Success;
+    ACFontInfo* fontinfo = NULL;
+    unsigned int saveAllStems = allstems;
+    AC_REPORTSTEMPTR saveHStemCB = gAddHStemCB, saveVStemCB = gAddVStemCB;
+    AC_REPORTZONEPTR saveCharCB = gAddCharExtremesCB;
+    AC_REPORTZONEPTR saveStemCB = gAddStemExtremesCB;
+    AC_RETRYPTR saveRetryCB = gReportRetryCB;
+    bool saveDoAligns = gDoAligns, saveDoStems = gDoStems;
+
+    if (!srcbezdata || !histograms)
+        return AC_InvalidParameterError;
+
+    memset(histograms, 0, sizeof(AC_StemHistograms));
+
+    StartMemoryStats();
+    if (ParseFontInfo(fontinfodata, &fontinfo))
+        return AC_FontinfoParseFail;
+
+    bezoutput = NewBuffer(1024);
+    if (!bezoutput) {
+        FreeFontInfo(fontinfo);
+        return AC_MemoryError;
+    }
+
+    AC_SetReportStemsCB(NULL, NULL, allStems);
+    gReportRetryCB = DiscardGlyphReports;
+    gDoStemHists = true;
+    InitReportHists(false);
+    set_errorproc(error_handler);
+
+    for (i = 0; i < glyphCount; i++) {
+        if (srcbezdata[i])
+            ReportGlyph(fontinfo, srcbezdata[i]);
+    }
+
+    if (!FinishStemHists(histograms)) {
+        AC_FreeStemHistograms(histograms);
+        result = AC_MemoryError;
+    }
+
+    gDoStemHists = false;
+    allstems = saveAllStems;
+    gAddHStemCB = saveHStemCB;
+    gAddVStemCB = saveVStemCB;
+    gAddCharExtremesCB = saveCharCB;
+    gAddStemExtremesCB = saveStemCB;
+    gReportRetryCB = saveRetryCB;
+    gDoAligns = saveDoAligns;
+    gDoStems = saveDoStems;
+
+    FreeBuffer(bezoutput);
+    bezoutput = NULL;
+    FreeFontInfo(fontinfo);
+
+    return result;
+}
+
+ACLIB_API int
+AC_DeriveFontInfo(const char** srcbezdata, size_t glyphCount, int unitsPerEm,
+                  char* fontinfodata, size_t* length)
+{
+    size_t i, infoLength;
+    int pass;
+    char bootinfo[200];
+    ACFontInfo* fontinfo = NULL;
+    unsigned int saveAllStems = allstems;
+    AC_REPORTSTEMPTR saveHStemCB = gAddHStemCB, saveVStemCB = gAddVStemCB;
+    AC_REPORTZONEPTR saveCharCB = gAddCharExtremesCB;
+    AC_REPORTZONEPTR saveStemCB = gAddStemExtremesCB;
+    AC_RETRYPTR saveRetryCB = gReportRetryCB;
+    bool saveDoAligns = gDoAligns, saveDoStems = gDoStems;
+
+    if (!srcbezdata || !fontinfodata || !length || unitsPerEm <= 0)
+        return AC_InvalidParameterError;
+
+    /* The glyphs are analysed with inactive alignment zones, outside of any
+     * reasonable glyph bounds, and a dominant stem wider than any real one. */
+    snprintf(bootinfo, sizeof(bootinfo),
+             "OrigEmSqUnits %d FlexOK false BaselineYCoord %d "
+             "BaselineOvershoot 0 CapHeight %d CapOvershoot 0 "
+             "DominantV [%d] DominantH [%d]",
+             unitsPerEm, -2 * unitsPerEm, 2 * unitsPerEm, unitsPerEm,
+             unitsPerEm);
+    StartMemoryStats();
+    if (ParseFontInfo(bootinfo, &fontinfo))
+        return AC_FontinfoParseFail;
+
+    bezoutput = NewBuffer(1024);
+    if (!bezoutput) {
+        FreeFontInfo(fontinfo);
+        return AC_MemoryError;
+    }
+
+    gReportRetryCB = DiscardGlyphReports;
+    InitReportHists(true);
+    set_errorproc(error_handler);
+
+    /* The zone and stem reporting modes prune hints differently, so each
+     * needs a pass of its own. Stems between curves are counted too: the
+     * main stems of fonts with bracketed serifs only join curves. */
+    for (pass = 0; pass < 2; pass++) {
+        if (pass == 0) {
+            AC_SetReportZonesCB(NULL, NULL);
+            gDoZoneHists = true;
+        } else {
+            AC_SetReportStemsCB(NULL, NULL, true);
+            gDoZoneHists = false;
+            gDoStemHists = true;
+        }
+        for (i = 0; i < glyphCount; i++) {
+            if (srcbezdata[i])
+                ReportGlyph(fontinfo, srcbezdata[i]);
+        }
+    }
+
+    infoLength = FormatDerivedFontInfo(unitsPerEm, fontinfodata, *length);
+
+    gDoStemHists = false;
+    allstems = saveAllStems;
+    gAddHStemCB = saveHStemCB;
+    gAddVStemCB = saveVStemCB;
+    gAddCharExtremesCB = saveCharCB;
+    gAddStemExtremesCB = saveStemCB;
+    gReportRetryCB = saveRetryCB;
+    gDoAligns = saveDoAligns;
+    gDoStems = saveDoStems;
+
+    FreeBuffer(bezoutput);
+    bezoutput = NULL;
+    FreeFontInfo(fontinfo);
+
+    if (infoLength < *length) {
+        *length = infoLength + 1;
+        return AC_Success;
+    } else {
+        *length = infoLength + 1;
+        return AC_DestBuffOfloError;
+    }
+}
+
+static void
+FreeStemHistogram(AC_StemHistogram* histogram)
+{
+    /* The widths are allocated straight from the memory manager, as they
+     * belong to the caller. */
+    if (histogram->widths)
+        AC_memmanageFuncPtr(AC_memmanageCtxPtr, histogram->widths, 0);
+    histogram->widths = NULL;
+    histogram->length = 0;
+}
+
+ACLIB_API void
+AC_FreeStemHistograms(AC_StemHistograms* histograms)
+{
+    if (!histograms)
+        return;
+
+    FreeStemHistogram(&histograms->hStraight);
+    FreeStemHistogram(&histograms->hCurved);
+    FreeStemHistogram(&histograms->vStraight);
+    FreeStemHistogram(&histograms->vCurved);
+}
+
 ACLIB_API void
 AC_initCallGlobals(void)
 {
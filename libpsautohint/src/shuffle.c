@@ -185,6 +185,7 @@ DoShuffleSubpaths(void)
     if (gDebug)
         PrintSumLinks((char*)sumlinks);
     while (true) {
+        CheckCancel();
         bst = -1;
         bstsum = 0;
         for (i = 0; i < rowcnt; i++) {
@@ -9,12 +9,81 @@
 
 #include "ac.h"
 
+/* Stem and zone histograms, used by AC_GetStemHistograms() and
+ * AC_DeriveFontInfo() in place of the report callbacks. The reports of the
+ * current glyph are kept aside until the glyph is done, so that the ones made
+ * before a coloring retry can be discarded. */
+
+enum
+{
+    HSTRAIGHT,
+    HCURVED,
+    VSTRAIGHT,
+    VCURVED,
+    NUMSTEMHISTS
+};
+
+/* Glyph tops and bottoms, by kind of reference glyph. */
+enum
+{
+    FLATCAPTOPS,
+    ROUNDCAPTOPS,
+    FLATLCTOPS,
+    ROUNDLCTOPS,
+    FLATBOTTOMS,
+    ROUNDBOTTOMS,
+    ALLTOPS,
+    ALLBOTTOMS,
+    NUMZONEHISTS
+};
+
+typedef struct
+{
+    AC_StemWidthCount count;
+    size_t lastGlyph; /* last glyph (+1) counted in count.glyphCount */
+} StemHistEntry;
+
+typedef struct
+{
+    StemHistEntry* entries;
+    size_t length, capacity;
+} StemHist;
+
+typedef struct
+{
+    int32_t hist;
+    Fixed width;
+} GlyphStem;
+
+bool gDoStemHists = false, gDoZoneHists = false;
+static StemHist stemHists[NUMSTEMHISTS], zoneHists[NUMZONEHISTS];
+static GlyphStem* glyphStems = NULL;
+static size_t numGlyphStems = 0, maxGlyphStems = 0, glyphIndex = 0;
+static Fixed glyphTop, glyphBot;
+static bool haveGlyphExtremes = false, mergeCurved = false;
+
+static void
+RecordStem(int32_t hist, Fixed width)
+{
+    if (numGlyphStems == maxGlyphStems) {
+        maxGlyphStems = NUMMAX(2 * maxGlyphStems, 64);
+        glyphStems = (GlyphStem*)ReallocateMem(
+          glyphStems, maxGlyphStems * sizeof(GlyphStem), "glyph stems");
+    }
+    glyphStems[numGlyphStems].hist = hist;
+    glyphStems[numGlyphStems].width = width;
+    numGlyphStems++;
+}
+
 void
 AddVStem(Fixed top, Fixed bottom, bool curved)
 {
     if (curved && !allstems)
         return;
 
+    if (gDoStemHists)
+        RecordStem(curved && !mergeCurved ? VCURVED : VSTRAIGHT, top - bottom);
+
     if (gAddVStemCB != NULL) {
         gAddVStemCB(top, bottom, gGlyphName);
     }
@@ -26,6 +95,9 @@ AddHStem(Fixed right, Fixed left, bool curved)
     if (curved && !allstems)
         return;
 
+    if (gDoStemHists)
+        RecordStem(curved && !mergeCurved ? HCURVED : HSTRAIGHT, right - left);
+
     if (gAddHStemCB != NULL) {
         gAddHStemCB(right, left, gGlyphName);
     }
@@ -34,6 +106,12 @@ AddHStem(Fixed right, Fixed left, bool curved)
 void
 AddCharExtremes(Fixed bot, Fixed top)
 {
+    if (gDoZoneHists) {
+        glyphTop = top;
+        glyphBot = bot;
+        haveGlyphExtremes = true;
+    }
+
     if (gAddCharExtremesCB != NULL) {
         gAddCharExtremesCB(top, bot, gGlyphName);
     }
@@ -46,3 +124,332 @@ AddStemExtremes(Fixed bot, Fixed top)
         gAddStemExtremesCB(top, bot, gGlyphName);
     }
 }
+
+/* If mergeCurvedStems is true, curved stems are counted in the histograms of
+ * the straight ones. */
+void
+InitReportHists(bool mergeCurvedStems)
+{
+    int32_t i;
+    mergeCurved = mergeCurvedStems;
+    for (i = 0; i < NUMSTEMHISTS; i++) {
+        stemHists[i].entries = NULL;
+        stemHists[i].length = stemHists[i].capacity = 0;
+    }
+    for (i = 0; i < NUMZONEHISTS; i++) {
+        zoneHists[i].entries = NULL;
+        zoneHists[i].length = zoneHists[i].capacity = 0;
+    }
+    glyphStems = NULL;
+    numGlyphStems = maxGlyphStems = glyphIndex = 0;
+    haveGlyphExtremes = false;
+}
+
+void
+DiscardGlyphReports(void)
+{
+    numGlyphStems = 0;
+    haveGlyphExtremes = false;
+}
+
+static void
+AddStemWidth(StemHist* hist, Fixed width)
+{
+    size_t lo = 0, hi = hist->length, mid;
+    StemHistEntry* entry;
+
+    /* entries are kept sorted by width */
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (hist->entries[mid].count.width < width)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == hist->length || hist->entries[lo].count.width != width) {
+        if (hist->length == hist->capacity) {
+            hist->capacity = NUMMAX(2 * hist->capacity, 32);
+            hist->entries = (StemHistEntry*)ReallocateMem(
+              hist->entries, hist->capacity * sizeof(StemHistEntry),
+              "stem histogram");
+        }
+        memmove(&hist->entries[lo + 1], &hist->entries[lo],
+                (hist->length - lo) * sizeof(StemHistEntry));
+        hist->length++;
+        entry = &hist->entries[lo];
+        entry->count.width = width;
+        entry->count.count = entry->count.glyphCount = 0;
+        entry->lastGlyph = 0;
+    } else
+        entry = &hist->entries[lo];
+    entry->count.count++;
+    if (entry->lastGlyph != glyphIndex) {
+        entry->lastGlyph = glyphIndex;
+        entry->count.glyphCount++;
+    }
+}
+
+static bool
+IsGlyphIn(const char* names)
+{
+    return gGlyphName[0] != '\0' && gGlyphName[1] == '\0' &&
+           strchr(names, gGlyphName[0]) != NULL;
+}
+
+static void
+CommitGlyphExtremes(void)
+{
+    AddStemWidth(&zoneHists[ALLTOPS], glyphTop);
+    AddStemWidth(&zoneHists[ALLBOTTOMS], glyphBot);
+    if (IsGlyphIn("EFHIKLTXZ"))
+        AddStemWidth(&zoneHists[FLATCAPTOPS], glyphTop);
+    else if (IsGlyphIn("CGOQS"))
+        AddStemWidth(&zoneHists[ROUNDCAPTOPS], glyphTop);
+    else if (IsGlyphIn("vwxyz"))
+        AddStemWidth(&zoneHists[FLATLCTOPS], glyphTop);
+    else if (IsGlyphIn("ceos"))
+        AddStemWidth(&zoneHists[ROUNDLCTOPS], glyphTop);
+    if (IsGlyphIn("EFHIKLTXZxz"))
+        AddStemWidth(&zoneHists[FLATBOTTOMS], glyphBot);
+    else if (IsGlyphIn("CGOSceos"))
+        AddStemWidth(&zoneHists[ROUNDBOTTOMS], glyphBot);
+}
+
+void
+CommitGlyphReports(void)
+{
+    size_t i;
+    glyphIndex++;
+    for (i = 0; i < numGlyphStems; i++)
+        AddStemWidth(&stemHists[glyphStems[i].hist], glyphStems[i].width);
+    numGlyphStems = 0;
+    if (haveGlyphExtremes)
+        CommitGlyphExtremes();
+    haveGlyphExtremes = false;
+}
+
+static bool
+CopyStemHist(StemHist* hist, AC_StemHistogram* dest)
+{
+    size_t i;
+    dest->widths = NULL;
+    dest->length = 0;
+    if (hist->length == 0)
+        return true;
+    dest->widths = (AC_StemWidthCount*)AC_memmanageFuncPtr(
+      AC_memmanageCtxPtr, NULL, hist->length * sizeof(AC_StemWidthCount));
+    if (dest->widths == NULL)
+        return false;
+    for (i = 0; i < hist->length; i++)
+        dest->widths[i] = hist->entries[i].count;
+    dest->length = hist->length;
+    return true;
+}
+
+static void
+FreeReportHists(void)
+{
+    int32_t i;
+    for (i = 0; i < NUMSTEMHISTS; i++) {
+        if (stemHists[i].entries)
+            UnallocateMem(stemHists[i].entries);
+    }
+    for (i = 0; i < NUMZONEHISTS; i++) {
+        if (zoneHists[i].entries)
+            UnallocateMem(zoneHists[i].entries);
+    }
+    if (glyphStems)
+        UnallocateMem(glyphStems);
+    InitReportHists(false);
+}
+
+bool
+FinishStemHists(AC_StemHistograms* histograms)
+{
+    bool result = true;
+
+    if (histograms) {
+        result = CopyStemHist(&stemHists[HSTRAIGHT], &histograms->hStraight) &&
+                 CopyStemHist(&stemHists[HCURVED], &histograms->hCurved) &&
+                 CopyStemHist(&stemHists[VSTRAIGHT], &histograms->vStraight) &&
+                 CopyStemHist(&stemHists[VCURVED], &histograms->vCurved);
+    }
+    FreeReportHists();
+    return result;
+}
+
+/* Returns the most frequent value of hist, in font units. */
+static bool
+HistMode(StemHist* hist, int32_t* value)
+{
+    size_t i, best = 0;
+    if (hist->length == 0)
+        return false;
+    for (i = 1; i < hist->length; i++) {
+        if (hist->entries[i].count.count > hist->entries[best].count.count)
+            best = i;
+    }
+    *value = FTrunc(FHalfRnd(hist->entries[best].count.width));
+    return true;
+}
+
+/* Type 1 fonts allow at most 12 StemSnap values. */
+#define MAXSTEMSNAP (12)
+
+/* Marks the histogram entries already taken by PickStemWidths. */
+#define PICKED ((size_t)-1)
+
+/* Widths this close to each other count as the same stem. */
+static int32_t
+StemTolerance(int32_t width)
+{
+    return NUMMAX(1, width / 25);
+}
+
+/* Rounds the widths of hist to font units, merging the entries that round to
+ * the same width, and scores each width with the number of glyphs that have
+ * a stem within StemTolerance of it. The score is kept in count.count. */
+static void
+ScoreStemWidths(StemHist* hist)
+{
+    size_t i, j, n = 0;
+    int32_t width, tol;
+
+    for (i = 0; i < hist->length; i++) {
+        width = FTrunc(FHalfRnd(hist->entries[i].count.width));
+        if (n > 0 && hist->entries[n - 1].count.width == width) {
+            hist->entries[n - 1].count.glyphCount +=
+              hist->entries[i].count.glyphCount;
+            continue;
+        }
+        hist->entries[n] = hist->entries[i];
+        hist->entries[n].count.width = width;
+        hist->entries[n].lastGlyph = 0;
+        n++;
+    }
+    hist->length = n;
+    for (i = 0; i < n; i++) {
+        StemHistEntry* entries = hist->entries;
+        width = entries[i].count.width;
+        tol = StemTolerance(width);
+        entries[i].count.count = entries[i].count.glyphCount;
+        for (j = i; j > 0 && width - entries[j - 1].count.width <= tol; j--)
+            entries[i].count.count += entries[j - 1].count.glyphCount;
+        for (j = i + 1; j < n && entries[j].count.width - width <= tol; j++)
+            entries[i].count.count += entries[j].count.glyphCount;
+    }
+}
+
+/* Writes the dominant width of hist, the one with the best score, and up to
+ * MAXSTEMSNAP - 1 other widths around it, in font units, to stems. The other
+ * widths are the best scored ones within a third of the dominant width that
+ * score at least half as well, leaving out those within StemTolerance of a
+ * width already taken. Returns the number of widths written. */
+static int32_t
+PickStemWidths(StemHist* hist, int32_t* stems)
+{
+    int32_t num = 0, i, width, lo = 0, hi = 0, minScore = 0;
+    size_t j, best;
+
+    ScoreStemWidths(hist);
+    while (num < MAXSTEMSNAP) {
+        best = hist->length;
+        for (j = 0; j < hist->length; j++) {
+            if (hist->entries[j].lastGlyph == PICKED)
+                continue;
+            width = hist->entries[j].count.width;
+            if (num > 0 && (width < lo || width > hi))
+                continue;
+            for (i = 0; i < num; i++) {
+                if (abs(stems[i] - width) <= StemTolerance(stems[i]))
+                    break;
+            }
+            if (i < num)
+                continue;
+            if (best == hist->length ||
+                hist->entries[j].count.count > hist->entries[best].count.count)
+                best = j;
+        }
+        if (best == hist->length ||
+            hist->entries[best].count.count < minScore)
+            break;
+        hist->entries[best].lastGlyph = PICKED;
+        width = hist->entries[best].count.width;
+        if (num == 0) {
+            lo = width - width / 3;
+            hi = width + width / 3;
+            minScore = (hist->entries[best].count.count + 1) / 2;
+        }
+        stems[num++] = width;
+    }
+    return num;
+}
+
+static size_t
+AppendStems(char* buf, size_t size, size_t len, const char* dominant,
+            const char* snap, StemHist* hist)
+{
+    int32_t stems[MAXSTEMSNAP], num, i, j, tmp;
+
+    num = PickStemWidths(hist, stems);
+    if (num == 0)
+        return len;
+    len += snprintf(buf + len, len < size ? size - len : 0, " %s [%d]",
+                    dominant, stems[0]);
+    /* StemSnap values are sorted */
+    for (i = 1; i < num; i++) {
+        for (j = i; j > 0 && stems[j - 1] > stems[j]; j--) {
+            tmp = stems[j];
+            stems[j] = stems[j - 1];
+            stems[j - 1] = tmp;
+        }
+    }
+    len += snprintf(buf + len, len < size ? size - len : 0, " %s [", snap);
+    for (i = 0; i < num; i++) {
+        len += snprintf(buf + len, len < size ? size - len : 0,
+                        i ? " %d" : "%d", stems[i]);
+    }
+    len += snprintf(buf + len, len < size ? size - len : 0, "]");
+    return len;
+}
+
+size_t
+FormatDerivedFontInfo(int unitsPerEm, char* buf, size_t size)
+{
+    int32_t base, capHeight, lcHeight, value;
+    int32_t baseOver = 0, capOver = 0, lcOver = 0;
+    bool haveLc;
+    size_t len;
+
+    /* Heights come from glyphs with flat tops and bottoms, overshoots from
+     * the round ones; without those, fall back to the most common glyph
+     * extremes of the font. */
+    if (!HistMode(&zoneHists[FLATBOTTOMS], &base) &&
+        !HistMode(&zoneHists[ALLBOTTOMS], &base))
+        base = 0;
+    if (HistMode(&zoneHists[ROUNDBOTTOMS], &value) && value < base)
+        baseOver = value - base;
+    if (!HistMode(&zoneHists[FLATCAPTOPS], &capHeight) &&
+        !HistMode(&zoneHists[ALLTOPS], &capHeight))
+        capHeight = unitsPerEm;
+    if (HistMode(&zoneHists[ROUNDCAPTOPS], &value) && value > capHeight)
+        capOver = value - capHeight;
+    haveLc = HistMode(&zoneHists[FLATLCTOPS], &lcHeight);
+    if (haveLc && HistMode(&zoneHists[ROUNDLCTOPS], &value) && value > lcHeight)
+        lcOver = value - lcHeight;
+
+    len = snprintf(buf, size,
+                   "OrigEmSqUnits %d BaselineYCoord %d "
+                   "BaselineOvershoot %d CapHeight %d CapOvershoot %d",
+                   unitsPerEm, base, baseOver, capHeight, capOver);
+    if (haveLc)
+        len += snprintf(buf + len, len < size ? size - len : 0,
+                        " LcHeight %d LcOvershoot %d", lcHeight, lcOver);
+    len = AppendStems(buf, size, len, "DominantV", "StemSnapV",
+                      &stemHists[VSTRAIGHT]);
+    len = AppendStems(buf, size, len, "DominantH", "StemSnapH",
+                      &stemHists[HSTRAIGHT]);
+
+    FreeReportHists();
+    return len;
+}
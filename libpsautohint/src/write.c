@@ -8,8 +8,11 @@
  */
 
 #include <math.h>
+#include <stdlib.h>
 
 #include "ac.h"
+#include "charpath.h"
+#include "opcodes.h"
 
 #define WRTABS_COMMENT (0)
 
@@ -17,11 +20,6 @@ Fixed currentx, currenty;
 bool firstFlex, wrtColorInfo;
 #define MAXS0LEN 127
 char S0[MAXS0LEN + 1];
-PClrPoint bst;
-PClrPoint prv_bst;
-char bch;
-Fixed bx, by;
-bool bstB;
 int16_t subpathcount;
 extern ACBuffer* bezoutput;
 
@@ -44,15 +42,17 @@ FRnd(int32_t x)
 static void
 WriteString(char* str)
 {
+    size_t len;
     if (!bezoutput) {
         LogMsg(LOGERROR, FATALERROR,
                "NULL output buffer while writing glyph: %s", gGlyphName);
         return;
     }
 
-    if ((bezoutput->length + strlen(str)) >= bezoutput->capacity) {
+    len = strlen(str);
+    if ((bezoutput->length + len) >= bezoutput->capacity) {
         size_t desiredsize =
-          NUMMAX(bezoutput->capacity * 2, bezoutput->capacity + strlen(str));
+          NUMMAX(bezoutput->capacity * 2, bezoutput->capacity + len);
         bezoutput->data =
           ReallocateMem(bezoutput->data, desiredsize, "output bez data");
         if (bezoutput->data)
@@ -60,8 +60,9 @@ WriteString(char* str)
         else
             return; /*FATAL ERROR*/
     }
-    strcat(bezoutput->data, str);
-    bezoutput->length += strlen(str);
+    /* append at the known length, strcat would rescan the whole glyph */
+    memcpy(bezoutput->data + bezoutput->length, str, len + 1);
+    bezoutput->length += len;
 }
 
 /* Note: The 8 bit fixed fraction cannot support more than 2 decimal places. */
@@ -158,20 +159,23 @@ wrtya(Fixed y)
 /*To avoid pointless hint subs*/
 #define HINTMAXSTR 2048
 static char hintmaskstr[HINTMAXSTR];
+static size_t hintmasklen;
 static char prevhintmaskstr[HINTMAXSTR];
 
-void
-safestrcat(char* s1, char* s2)
+static void
+safestrcat(char* s2)
 {
-    if (strlen(s1) + strlen(s2) + 1 > HINTMAXSTR) {
+    size_t len = strlen(s2);
+    if (hintmasklen + len + 1 > HINTMAXSTR) {
         LogMsg(LOGERROR, FATALERROR,
                "ERROR: Hint information overflowing buffer: %s\n", gGlyphName);
     } else {
-        strcat(s1, s2);
+        memcpy(hintmaskstr + hintmasklen, s2, len + 1);
+        hintmasklen += len;
     }
 }
 
-#define sws(str) safestrcat(hintmaskstr, (char*)str)
+#define sws(str) safestrcat((char*)str)
 
 #define SWRTNUM(i)                                                             \
     {                                                                          \
@@ -185,25 +189,6 @@ safestrcat(char* s1, char* s2)
         sws(S0);                                                               \
     }
 
-static void
-NewBest(PClrPoint lst)
-{
-    Fixed x0, x1, y0, y1;
-    bst = lst;
-    bch = lst->c;
-    if (bch == 'y' || bch == 'm') {
-        bstB = true;
-        x0 = lst->x0;
-        x1 = lst->x1;
-        bx = NUMMIN(x0, x1);
-    } else {
-        bstB = false;
-        y0 = lst->y0;
-        y1 = lst->y1;
-        by = NUMMIN(y0, y1);
-    }
-}
-
 static void
 WriteOne(const ACFontInfo* fontinfo, Fixed s)
 { /* write s to output file */
@@ -252,68 +237,96 @@ WritePointItem(const ACFontInfo* fontinfo, PClrPoint lst)
     sws("\n");
 }
 
-static void
-WrtPntLst(const ACFontInfo* fontinfo, PClrPoint lst)
+typedef struct
 {
-    PClrPoint ptLst;
-    char ch;
-    Fixed x0, x1, y0, y1;
-    ptLst = lst;
-
-    while (lst != NULL) { /* mark all as not yet done */
-        lst->done = false;
-        lst = lst->next;
-    }
-    while (true) { /* write in sort order */
-        lst = ptLst;
-        bst = NULL;
-        while (lst != NULL) { /* find first not yet done as init best */
-            if (!lst->done) {
-                NewBest(lst);
-                break;
-            }
-            lst = lst->next;
-        }
-        if (bst == NULL) {
-            break; /* finished with entire list */
-        }
-        lst = bst->next;
-        while (lst != NULL) { /* search for best */
-            if (!lst->done) {
-                ch = lst->c;
-                if (ch > bch) {
-                    NewBest(lst);
-                } else if (ch == bch) {
-                    if (bstB) {
-                        x0 = lst->x0;
-                        x1 = lst->x1;
-                        if (NUMMIN(x0, x1) < bx) {
-                            NewBest(lst);
-                        }
-                    } else {
-                        y0 = lst->y0;
-                        y1 = lst->y1;
-                        if (NUMMIN(y0, y1) < by) {
-                            NewBest(lst);
-                        }
-                    }
-                }
-            }
-            lst = lst->next;
-        }
-        bst->done = true; /* mark as having been done */
-        WritePointItem(fontinfo, bst);
+    PClrPoint pt;
+    Fixed loc;
+    int32_t order;
+} PntItem;
+
+/* the hints last written, to tell if the next ones are the same */
+static PntItem* prevItems;
+static int32_t prevCount;
+
+static int
+CmpPntItems(const void* a, const void* b)
+{
+    /* 'y' 'v' 'm' 'b' in turn, each from the lowest, else in list order */
+    const PntItem* ia = (const PntItem*)a;
+    const PntItem* ib = (const PntItem*)b;
+    if (ia->pt->c != ib->pt->c)
+        return ib->pt->c - ia->pt->c;
+    if (ia->loc != ib->loc)
+        return ia->loc < ib->loc ? -1 : 1;
+    return ia->order - ib->order;
+}
+
+static int32_t
+SortPntLst(PClrPoint lst, PntItem** pItems)
+{
+    PClrPoint pt;
+    PntItem* items;
+    int32_t n = 0;
+    for (pt = lst; pt != NULL; pt = pt->next)
+        n++;
+    items = (PntItem*)Alloc(n * sizeof(PntItem));
+    for (pt = lst, n = 0; pt != NULL; pt = pt->next, n++) {
+        items[n].pt = pt;
+        if (pt->c == 'y' || pt->c == 'm')
+            items[n].loc = NUMMIN(pt->x0, pt->x1);
+        else
+            items[n].loc = NUMMIN(pt->y0, pt->y1);
+        items[n].order = n;
     }
+    qsort(items, n, sizeof(PntItem), CmpPntItems);
+    *pItems = items;
+    return n;
+}
+
+static bool
+SamePntItems(PntItem* items, int32_t n)
+{
+    int32_t i;
+    PClrPoint p, q;
+    if (n != prevCount)
+        return false;
+    for (i = 0; i < n; i++) {
+        p = items[i].pt;
+        q = prevItems[i].pt;
+        if (p != q &&
+            (p->c != q->c || p->x0 != q->x0 || p->y0 != q->y0 ||
+             p->x1 != q->x1 || p->y1 != q->y1 || p->p0 != q->p0 ||
+             p->p1 != q->p1))
+            return false;
+    }
+    return true;
+}
+
+static void
+WrtPntLst(const ACFontInfo* fontinfo, PntItem* items, int32_t n)
+{
+    int32_t i;
+    hintmaskstr[0] = '\0';
+    hintmasklen = 0;
+    for (i = 0; i < n; i++)
+        WritePointItem(fontinfo, items[i].pt);
+    prevItems = items;
+    prevCount = n;
 }
 
 static void
 wrtnewclrs(const ACFontInfo* fontinfo, PPathElt e)
 {
+    PntItem* items;
+    int32_t n;
     if (!wrtColorInfo) {
         return;
     }
-    hintmaskstr[0] = '\0';
-    WrtPntLst(fontinfo, gPtLstArray[e->newcolors]);
+    n = SortPntLst(gPtLstArray[e->newcolors], &items);
+    if (SamePntItems(items, n)) {
+        return; /* these would be written exactly as the previous hints */
+    }
+    WrtPntLst(fontinfo, items, n);
     if (strcmp(prevhintmaskstr, hintmaskstr)) {
         WriteString("beginsubr snc\n");
         WriteString(hintmaskstr);
@@ -593,9 +606,12 @@ SaveFile(const ACFontInfo* fontinfo)
     wrtColorInfo = (gPathStart != NULL && gPathStart != gPathEnd);
     NumberPath();
     prevhintmaskstr[0] = '\0';
+    prevItems = NULL;
+    prevCount = 0;
     if (wrtColorInfo && (!e->newcolors)) {
-        hintmaskstr[0] = '\0';
-        WrtPntLst(fontinfo, gPtLstArray[0]);
+        PntItem* items;
+        int32_t n = SortPntLst(gPtLstArray[0], &items);
+        WrtPntLst(fontinfo, items, n);
         WriteString(hintmaskstr);
         strcpy(prevhintmaskstr, hintmaskstr);
     }
@@ -665,3 +681,87 @@ SaveFile(const ACFontInfo* fontinfo)
     }
     WriteString("ed\n");
 }
+
+static void
+wrtfixa(Fixed x)
+{
+    if (FracPart(x) == 0) {
+        WRTNUM(FTrunc(x));
+    } else {
+        WRTRNUM((float)FIXED2FLOAT(x));
+    }
+}
+
+static void
+WriteCharPathHints(PHintElt hints)
+{
+    for (; hints != NULL; hints = hints->next) {
+        wrtfixa(hints->leftorbot);
+        wrtfixa(hints->rightortop - hints->leftorbot);
+        switch (hints->type) {
+            case RB:
+                WriteString("rb");
+                break;
+            case RY:
+                WriteString("ry");
+                break;
+            case RM + ESCVAL:
+                WriteString("rm");
+                break;
+            case RV + ESCVAL:
+                WriteString("rv");
+                break;
+        }
+        WriteString(" % ");
+        WRTNUM(hints->pathix1);
+        WRTNUM(hints->pathix2);
+        WriteString("\n");
+    }
+}
+
+/* Writes a glyph read for blended data, with its hints, in the same format
+   as SaveFile. */
+void
+SaveCharPath(PPathList plist)
+{
+    int32_t i;
+
+    WriteString("% ");
+    WriteString(gGlyphName);
+    WriteString("\n");
+    WriteCharPathHints(plist->mainhints);
+    WriteString("sc\n");
+    for (i = 0; i < plist->count; i++) {
+        PCharPathElt e = &plist->path[i];
+        if (e->hints != NULL) {
+            WriteString("beginsubr snc\n");
+            WriteCharPathHints(e->hints);
+            WriteString("endsubr enc\nnewcolors\n");
+        }
+        switch (e->type) {
+            case RMT:
+                wrtxa(e->x);
+                wrtya(e->y);
+                WriteString("mt\n");
+                break;
+            case RDT:
+                wrtxa(e->x);
+                wrtya(e->y);
+                WriteString("dt\n");
+                break;
+            case RCT:
+                wrtxa(e->x1);
+                wrtya(e->y1);
+                wrtxa(e->x2);
+                wrtya(e->y2);
+                wrtxa(e->x3);
+                wrtya(e->y3);
+                WriteString("ct\n");
+                break;
+            case CP:
+                WriteString("cp\n");
+                break;
+        }
+    }
+    WriteString("ed\n");
+}
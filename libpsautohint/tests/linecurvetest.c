@@ -0,0 +1,60 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Hints a glyph whose linear curves are changed to lines while the hints are
+ * generated, and checks the hints are found from the edited path. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "psautohint.h"
+
+static void
+quietReport(char* msg)
+{
+    (void)msg;
+}
+
+static const char* fontinfo =
+  "OrigEmSqUnits 1000 FontName Test BaselineYCoord 0 BaselineOvershoot -12 "
+  "CapHeight 660 CapOvershoot 12 LcHeight 480 LcOvershoot 12 "
+  "DominantV [90] StemSnapV [90 110] DominantH [70] StemSnapH [70 80]";
+
+/* The two curves at the bottom are lines, the first one with its control
+ * points before its start. */
+static const char* glyph = "% linecurve\nsc\n493 58 mt\n209 58 dt\n209 -37 dt\n"
+                           "144 -37 441 -37 427 -37 ct\n"
+                           "421 -37 495 -37 493 -37 ct\ncp\ned\n";
+
+static const char* expected = "% linecurve\n209 284 ry % 2 1 \n"
+                              "-37 95 rb % 4 1 \nsc\n493 58 mt\n209 58 dt\n"
+                              "209 -37 dt\n427 -37 dt\n493 -37 dt\ncp\ned\n";
+
+int
+main(void)
+{
+    char output[4096];
+    size_t length = sizeof(output);
+    int result;
+
+    AC_SetReportCB(quietReport, false);
+    result = AutoColorString(glyph, fontinfo, output, &length, true, true,
+                             true, false);
+    if (result != AC_Success) {
+        fprintf(stderr, "linecurvetest: hinting failed with %d\n", result);
+        return 1;
+    }
+    if (strcmp(output, expected) != 0) {
+        fprintf(stderr, "linecurvetest: expected\n%sbut got\n%s", expected,
+                output);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Runs AutoColorStringMM with memory limits that make it fail at every point
+ * it allocates memory, and checks that it returns AC_MemoryError, frees
+ * every block it allocated and never frees a block twice. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "psautohint.h"
+
+#define MAXBLOCKS 100000
+
+static void* blocks[MAXBLOCKS];
+static size_t numBlocks = 0;
+static int badFrees = 0;
+
+static size_t
+findBlock(void* ptr)
+{
+    size_t i;
+    for (i = 0; i < numBlocks; i++) {
+        if (blocks[i] == ptr)
+            return i;
+    }
+    return numBlocks;
+}
+
+/* A memory manager that keeps track of the blocks in use. */
+static void*
+trackingManager(void* ctxptr, void* old, size_t size)
+{
+    size_t i = numBlocks;
+    void* ptr;
+
+    (void)ctxptr;
+    if (old != NULL) {
+        i = findBlock(old);
+        if (i == numBlocks) {
+            badFrees++;
+            return NULL;
+        }
+    }
+    if (size == 0) {
+        free(old);
+        blocks[i] = blocks[--numBlocks];
+        return NULL;
+    }
+    ptr = realloc(old, size);
+    if (ptr == NULL || (old == NULL && numBlocks == MAXBLOCKS))
+        return ptr;
+    if (old == NULL)
+        i = numBlocks++;
+    blocks[i] = ptr;
+    return ptr;
+}
+
+static void
+quietReport(char* msg)
+{
+    (void)msg;
+}
+
+static const char* fontinfo =
+  "OrigEmSqUnits 1000 FontName Test BaselineOvershoot -12 BaselineYCoord 0 "
+  "CapHeight 652 CapOvershoot 12 LcHeight 486 LcOvershoot 12 "
+  "DominantV [148] StemSnapV [148] DominantH [115] StemSnapH [115]";
+
+/* An "A" with a staircase of bars, so that the hinted masters are longer
+ * than the 1024 bytes their output buffers start with. */
+static const char* masters[] = {
+    "% A\nsc 9 0 mt\n159 0 dt\n244 330 dt\n261 395 279 471 295 540 ct\n"
+    "299 540 dt\n314 471 334 395 351 330 ct\n435 0 dt\n591 0 dt\n"
+    "388 652 dt\n212 652 dt\ncp\n143 155 mt\n455 155 dt\n455 270 dt\n"
+    "143 270 dt\ncp\n"
+    "620 40 mt\n680 40 dt\n680 80 dt\n620 80 dt\ncp\n"
+    "710 115 mt\n770 115 dt\n770 155 dt\n710 155 dt\ncp\n"
+    "800 190 mt\n860 190 dt\n860 230 dt\n800 230 dt\ncp\n"
+    "890 265 mt\n950 265 dt\n950 305 dt\n890 305 dt\ncp\n"
+    "980 340 mt\n1040 340 dt\n1040 380 dt\n980 380 dt\ncp\n"
+    "1070 415 mt\n1130 415 dt\n1130 455 dt\n1070 455 dt\ncp\n"
+    "1160 490 mt\n1220 490 dt\n1220 530 dt\n1160 530 dt\ncp\n"
+    "1250 565 mt\n1310 565 dt\n1310 605 dt\n1250 605 dt\ncp\ned\n",
+    "% A\nsc 19 0 mt\n199 0 dt\n264 330 dt\n281 395 299 471 305 540 ct\n"
+    "309 540 dt\n324 471 344 395 361 330 ct\n425 0 dt\n611 0 dt\n"
+    "408 652 dt\n202 652 dt\ncp\n153 145 mt\n465 145 dt\n465 280 dt\n"
+    "153 280 dt\ncp\n"
+    "630 40 mt\n690 40 dt\n690 80 dt\n630 80 dt\ncp\n"
+    "720 115 mt\n780 115 dt\n780 155 dt\n720 155 dt\ncp\n"
+    "810 190 mt\n870 190 dt\n870 230 dt\n810 230 dt\ncp\n"
+    "900 265 mt\n960 265 dt\n960 305 dt\n900 305 dt\ncp\n"
+    "990 340 mt\n1050 340 dt\n1050 380 dt\n990 380 dt\ncp\n"
+    "1080 415 mt\n1140 415 dt\n1140 455 dt\n1080 455 dt\ncp\n"
+    "1170 490 mt\n1230 490 dt\n1230 530 dt\n1170 530 dt\ncp\n"
+    "1260 565 mt\n1320 565 dt\n1320 605 dt\n1260 605 dt\ncp\ned\n",
+};
+
+#define NMASTERS (sizeof(masters) / sizeof(masters[0]))
+
+static int
+hintMasters(char** outputs, size_t* lengths)
+{
+    size_t i;
+    for (i = 0; i < NMASTERS; i++)
+        lengths[i] = 4096;
+    return AutoColorStringMM(masters, fontinfo, NMASTERS, outputs, lengths,
+                             true, true, false);
+}
+
+int
+main(void)
+{
+    char buffers[NMASTERS][4096];
+    char* outputs[NMASTERS];
+    size_t lengths[NMASTERS], i, limit, failures = 0;
+    AC_MemoryStats stats;
+    int result, errors = 0;
+
+    for (i = 0; i < NMASTERS; i++)
+        outputs[i] = buffers[i];
+    AC_SetMemManager(NULL, trackingManager);
+    AC_SetReportCB(quietReport, false);
+
+    result = hintMasters(outputs, lengths);
+    AC_GetMemoryStats(&stats);
+    if (result != AC_Success) {
+        fprintf(stderr, "mastertest: hinting failed with %d\n", result);
+        return 1;
+    }
+
+    for (limit = 1; limit <= stats.peakBytes; limit += 8) {
+        AC_SetMemoryLimit(limit);
+        result = hintMasters(outputs, lengths);
+        if (result == AC_MemoryError)
+            failures++;
+        else if (result != AC_Success) {
+            fprintf(stderr, "mastertest: limit %lu gave %d\n",
+                    (unsigned long)limit, result);
+            errors++;
+        }
+        if (numBlocks != 0 || badFrees != 0) {
+            fprintf(stderr,
+                    "mastertest: limit %lu left %lu blocks, %d bad frees\n",
+                    (unsigned long)limit, (unsigned long)numBlocks, badFrees);
+            errors++;
+            break;
+        }
+    }
+    AC_SetMemoryLimit(0);
+
+    if (failures == 0) {
+        fprintf(stderr, "mastertest: no limit made hinting fail\n");
+        errors++;
+    }
+    return errors != 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Compares VertQuo, HorzQuo and ATan, which skip the float math for the
+ * clear-cut deltas, with the float versions they used to be. */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "ac.h"
+
+#define Interpolate(q, v0, q0, v1, q1) (v0 + (q - q0) * ((v1 - v0) / (q1 - q0)))
+
+static Fixed
+HVnessRef(float* pq)
+{
+    float q;
+    float result;
+    q = *pq;
+    if (q < .25)
+        result = (float)Interpolate(q, 1.0, 0.0, .841, .25);
+    else if (q < .5)
+        result = (float)Interpolate(q, .841, .25, .707, .5);
+    else if (q < 1)
+        result = (float)Interpolate(q, .707, .5, .5, 1.0);
+    else if (q < 2)
+        result = (float)Interpolate(q, .5, 1.0, .25, 2.0);
+    else if (q < 4)
+        result = (float)Interpolate(q, .25, 2.0, 0.0, 4.0);
+    else
+        result = 0.0;
+    return acpflttofix(&result);
+}
+
+static Fixed
+VertQuoRef(Fixed xk, Fixed yk, Fixed xl, Fixed yl)
+{
+    Fixed xabs, yabs;
+    float rx, ry, q;
+    xabs = xk - xl;
+    if (xabs < 0)
+        xabs = -xabs;
+    if (xabs == 0)
+        return FixOne;
+    yabs = yk - yl;
+    if (yabs < 0)
+        yabs = -yabs;
+    if (yabs == 0)
+        return 0;
+    acfixtopflt(xabs, &rx);
+    acfixtopflt(yabs, &ry);
+    q = (float)(rx * rx) / (gTheta * ry);
+    return HVnessRef(&q);
+}
+
+static Fixed
+HorzQuoRef(Fixed xk, Fixed yk, Fixed xl, Fixed yl)
+{
+    Fixed xabs, yabs;
+    float rx, ry, q;
+    yabs = yk - yl;
+    if (yabs < 0)
+        yabs = -yabs;
+    if (yabs == 0)
+        return FixOne;
+    xabs = xk - xl;
+    if (xabs < 0)
+        xabs = -xabs;
+    if (xabs == 0)
+        return 0;
+    acfixtopflt(xabs, &rx);
+    acfixtopflt(yabs, &ry);
+    q = (float)(ry * ry) / (gTheta * rx);
+    return HVnessRef(&q);
+}
+
+#define DEG(x) ((x)*57.29577951308232088)
+static Fixed
+ATanRef(Fixed a, Fixed b)
+{
+    float aa, bb, cc;
+    acfixtopflt(a, &aa);
+    acfixtopflt(b, &bb);
+    cc = (float)DEG(atan2((double)aa, (double)bb));
+    while (cc < 0)
+        cc += 360.0;
+    return acpflttofix(&cc);
+}
+
+static int errors = 0;
+
+static void
+check(Fixed a, Fixed b)
+{
+    if (VertQuo(a, b, 0, 0) != VertQuoRef(a, b, 0, 0)) {
+        fprintf(stderr, "quotest: VertQuo of %d %d is %d, not %d\n", a, b,
+                VertQuo(a, b, 0, 0), VertQuoRef(a, b, 0, 0));
+        errors++;
+    }
+    if (HorzQuo(a, b, 0, 0) != HorzQuoRef(a, b, 0, 0)) {
+        fprintf(stderr, "quotest: HorzQuo of %d %d is %d, not %d\n", a, b,
+                HorzQuo(a, b, 0, 0), HorzQuoRef(a, b, 0, 0));
+        errors++;
+    }
+    /* CheckSmoothness never asks for the angle of a zero delta */
+    if ((a != 0 || b != 0) && ATan(a, b) != ATanRef(a, b)) {
+        fprintf(stderr, "quotest: ATan of %d %d is %d, not %d\n", a, b,
+                ATan(a, b), ATanRef(a, b));
+        errors++;
+    }
+}
+
+static uint32_t seed = 2463534242u;
+
+/* A random delta of up to bits bits, either sign. */
+static Fixed
+randomDelta(int bits)
+{
+    Fixed v;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    v = (Fixed)((seed >> 1) & ((1u << bits) - 1));
+    return (seed & 1) ? -v : v;
+}
+
+int
+main(void)
+{
+    static const Fixed extremes[] = { 1,       255,        FixOne,
+                                      65535,   1 << 20,    1 << 24,
+                                      1 << 29, FixInt(8000) };
+    Fixed a, b;
+    long i, j;
+
+    /* as InitData sets it */
+    gTheta = (float).38;
+
+    /* all the small deltas */
+    for (a = -1024; a <= 1024; a++) {
+        for (b = -1024; b <= 1024; b++)
+            check(a, b);
+    }
+    /* deltas of any size and shape */
+    for (i = 0; i < 1000000; i++)
+        check(randomDelta(1 + i % 30), randomDelta(1 + (i / 30) % 30));
+    /* the largest deltas, alone and together */
+    for (i = 0; i < (long)(sizeof(extremes) / sizeof(extremes[0])); i++) {
+        for (j = 0; j < (long)(sizeof(extremes) / sizeof(extremes[0])); j++) {
+            check(extremes[i], extremes[j]);
+            check(-extremes[i], extremes[j]);
+            check(extremes[i], -extremes[j]);
+            check(-extremes[i], -extremes[j]);
+            check(extremes[i], 0);
+            check(0, -extremes[j]);
+        }
+    }
+    return errors != 0;
+}
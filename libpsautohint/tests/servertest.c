@@ -0,0 +1,75 @@
+/*
+ * Copyright 2014 Adobe Systems Incorporated (http://www.adobe.com/).
+ * All Rights Reserved.
+ *
+ * This software is licensed as OpenSource, under the Apache License, Version
+ * 2.0.
+ * This license is available at: http://opensource.org/licenses/Apache-2.0.
+ */
+
+/* Sends requests with payload lengths that do not fit in memory to
+ * autohintexe -S, and checks that they get an error response instead of
+ * being read into a buffer that is too short. Run from libpsautohint. */
+
+#include <stdio.h>
+#include <string.h>
+
+#define OUTPUT "tests/servertest.out"
+
+static const char* fontinfo =
+  "OrigEmSqUnits 1000 FontName Test BaselineYCoord 0 BaselineOvershoot -12 "
+  "CapHeight 660 CapOvershoot 12 DominantV [90] DominantH [70]";
+
+/* Sends request, a header line and its payload, to a new server and checks
+ * that the last response is the error expected. */
+static int
+checkRequest(const char* request, const char* expected)
+{
+    char response[256];
+    size_t length;
+    FILE* server;
+    FILE* output;
+    int status;
+
+    server = popen("./autohintexe -S > " OUTPUT, "w");
+    if (server == NULL) {
+        fprintf(stderr, "servertest: could not start autohintexe\n");
+        return 1;
+    }
+    fprintf(server, "fontinfo %lu\n%s", (unsigned long)strlen(fontinfo),
+            fontinfo);
+    /* Some payload bytes for an overflowing read to write. */
+    fprintf(server, "%s%0200d", request, 0);
+    status = pclose(server);
+
+    output = fopen(OUTPUT, "rb");
+    if (output == NULL) {
+        fprintf(stderr, "servertest: no output from autohintexe\n");
+        return 1;
+    }
+    length = fread(response, 1, sizeof(response) - 1, output);
+    response[length] = '\0';
+    fclose(output);
+    remove(OUTPUT);
+
+    if (status != 0 || strstr(response, expected) == NULL) {
+        fprintf(stderr, "servertest: %.*s got status %d and\n%s\n",
+                (int)strcspn(request, "\n"), request, status, response);
+        return 1;
+    }
+    return 0;
+}
+
+int
+main(void)
+{
+    static const char* tooLong = "error 25\nRequest payload too long.";
+    int errors = 0;
+
+    errors += checkRequest("hint 1 18446744073709551615\n", tooLong);
+    errors += checkRequest("hint 1 4611686018427387904\n", tooLong);
+    errors += checkRequest("hint 1 4294967295\n", tooLong);
+    errors += checkRequest("fontinfo 18446744073709551615\n", tooLong);
+    errors += checkRequest("fontinfo -1\n", tooLong);
+    return errors != 0;
+}
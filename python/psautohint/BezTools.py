@@ -17,6 +17,7 @@ from fontTools.misc.psCharStrings import T2OutlineExtractor, SimpleT2Decompiler
 
 from psautohint import FDKUtils
 from psautohint import ConvertFontToCID
+from psautohint import _psautohint
 
 debug = 0
 def debugMsg(*args):
@@ -289,6 +290,14 @@ def convertT2GlyphToBez(t2CharString, removeHints = 0, allowDecimals = 0):
 		t2Wdth = None
 	return "".join(extractor.bezProgram), extractor.hintCount > 0, t2Wdth
 
+def compileSubrs(subrs):
+	bytecode = []
+	for subr in subrs:
+		if subr.bytecode is None:
+			subr.compile()
+		bytecode.append(subr.bytecode)
+	return bytecode
+
 class HintMask:
 	# class used to collect hints for the current hint mask when converting bez to T2.
 	def __init__(self, listPos):
@@ -1140,6 +1149,8 @@ class CFFFontData:
 		self.charStrings = topDict.CharStrings
 		self.charStringIndex = self.charStrings.charStringsIndex
 		self.allowDecimalCoords = False
+		self.globalSubrBytecode = None
+		self.localSubrBytecode = {}
 
 	def getGlyphList(self):
 		fontGlyphList = self.ttFont.getGlyphOrder()
@@ -1162,7 +1173,26 @@ class CFFFontData:
 		gid = self.charStrings.charStrings[glyphName]
 		t2CharString = self.charStringIndex[gid]
 		try:
-			bezString, hasHints, t2Wdth = convertT2GlyphToBez(t2CharString,
+			converted = None
+			if removeHints:
+				# The native conversion runs the compiled charstring, and
+				# leaves what it does not handle, such as SEAC glyphs, to
+				# the Python code.
+				localSubrs, globalSubrs = self.getSubrBytecode(t2CharString)
+				if t2CharString.bytecode is None:
+					t2CharString.compile()
+				converted = _psautohint.t2_to_bez(t2CharString.bytecode,
+								localSubrs, globalSubrs, self.allowDecimalCoords)
+			if converted is not None:
+				bezString, hasHints, widthArg = converted
+				private = t2CharString.private
+				if widthArg is not None:
+					t2Wdth = private.nominalWidthX + widthArg
+				else:
+					t2Wdth = private.defaultWidthX
+				t2Wdth = t2Wdth - private.nominalWidthX
+			else:
+				bezString, hasHints, t2Wdth = convertT2GlyphToBez(t2CharString,
 														removeHints,
 														self.allowDecimalCoords)
 			# Note: the glyph name is important, as it is used by autohintexe
@@ -1177,7 +1207,27 @@ class CFFFontData:
 			bezString = None
 		return bezString, t2Wdth, hasHints
 
+	def getSubrBytecode(self, t2CharString):
+		# Compiled subroutines for the native conversion. The local ones
+		# are kept per private dict, as each FDArray font has its own.
+		if self.globalSubrBytecode is None:
+			self.globalSubrBytecode = compileSubrs(t2CharString.globalSubrs)
+		private = t2CharString.private
+		localSubrs = self.localSubrBytecode.get(id(private))
+		if localSubrs is None:
+			localSubrs = compileSubrs(getattr(private, "Subrs", []))
+			self.localSubrBytecode[id(private)] = localSubrs
+		return localSubrs, self.globalSubrBytecode
+
 	def updateFromBez(self, bezData, glyphName, width, beVerbose):
+		# The native conversion gives the same charstring, already compiled,
+		# but leaves the glyphs it does not handle to the Python code.
+		bytecode = _psautohint.bez_to_t2(bezData, width)
+		if bytecode is not None:
+			gid = self.charStrings.charStrings[glyphName]
+			self.charStringIndex[gid].setBytecode(bytecode)
+			return
+
 		t2Program = [width] + convertBezToT2(bezData)
 		if t2Program:
 			gid = self.charStrings.charStrings[glyphName]
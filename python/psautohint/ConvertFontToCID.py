@@ -22,6 +22,7 @@ __copyright__ = """Copyright 2014 Adobe Systems Incorporated (http://www.adobe.c
 
 import re
 import types
+import hashlib
 
 from psautohint import FDKUtils
 
@@ -188,10 +189,79 @@ class FDDict:
 			printStr.append("%s" % (val))
 		return " ".join(printStr)
 
-def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueFuzz):
-	# fontDictList may or may not already contain a font dict taken from the source font top FontDict.
-	fdGlyphDict = {} # The map of glyph names to font dict: the index into fontDictList.
-	finalFDict = None # The user-specified set of blue values to write into the output font, some sort of merge of the individual font dicts. May not be supplied.
+class FontInfoData:
+	"""
+	The FDDict and GlyphSet definitions of a fontinfo file, in file order,
+	as (kFDDictToken, dict name, [(key, value), ...]) and
+	(kGlyphSetToken, set name, [pattern, ...]).
+	"""
+	def __init__(self, items):
+		self.items = items
+		self.matchers = None
+
+	def getMatchers(self):
+		# The glyph set patterns, compiled into as few expressions as
+		# Python allows. Each pattern is a lookahead searching the whole
+		# name, so one match of an expression tells which of its patterns is
+		# the last one that matches.
+		if self.matchers != None:
+			return self.matchers
+		patterns = []
+		for item in self.items:
+			if item[0] == kGlyphSetToken:
+				for pattern in item[2]:
+					patterns.append((pattern, item[1]))
+		matchers = []
+		start = 0
+		while start < len(patterns):
+			chunk = patterns[start:start + kMaxMatcherPatterns]
+			for pattern, setName in chunk:
+				re.compile(pattern) # a bad pattern must not combine with the next.
+			try:
+				if kBackReferencePattern.search("".join(pattern for pattern, setName in chunk)):
+					raise re.error("back reference")
+				expression = "".join("(?:(?=.*?(?P<p%d>%s)))?" % (start + pi, pattern) for pi, (pattern, setName) in enumerate(chunk))
+				matchers.append((re.compile(expression), start, True))
+			except (re.error, OverflowError, AssertionError):
+				# A pattern that does not combine with others is matched on
+				# its own.
+				for pi, (pattern, setName) in enumerate(chunk):
+					matchers.append((re.compile(pattern), start + pi, False))
+			start += len(chunk)
+		self.matchers = (matchers, patterns)
+		return self.matchers
+
+	def matchGlyph(self, gname):
+		# Returns the index of the last pattern that matches the glyph name,
+		# or None.
+		matchers, patterns = self.getMatchers()
+		for matcher, start, combined in reversed(matchers):
+			if not combined:
+				if matcher.search(gname):
+					return start
+				continue
+			name = matcher.match(gname).lastgroup
+			if name == None:
+				continue # none of the lookaheads matched.
+			return int(name[1:])
+		return None
+
+# Python 2 allows at most 100 groups in an expression.
+kMaxMatcherPatterns = 90
+kBackReferencePattern = re.compile(r"\\[1-9]|\(\?P[=<]|\(\?\(|\(\?[aiLmsux]")
+
+# Parsed fontinfo files, by the hash of their data.
+fontInfoCache = {}
+
+def parseFontInfoData(data):
+	if isinstance(data, bytes):
+		key = hashlib.sha1(data).hexdigest()
+	else:
+		key = hashlib.sha1(data.encode("utf-8")).hexdigest()
+	try:
+		return fontInfoCache[key]
+	except KeyError:
+		pass
 
 	# Get rid of comments.
 	data = re.sub(r"#[^\r\n]+[\r\n]", "", data)
@@ -205,8 +275,7 @@ def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueF
 	inDictValue = 2
 	dictState = 3
 	glyphSetState = 4
-	fdIndexDict = {}
-	lenSrcFontDictList = len(fontDictList)
+	items = []
 	
 	state = baseState
 	
@@ -221,22 +290,15 @@ def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueF
 					state = dictState
 					dictName = tokenList[i]
 					i += 1
-					fdDict = FDDict()
-					fdDict.DictName = dictName
-					if dictName == kFinalDictName:
-						# This is dict is NOT used to hint any glyphs; it is used
-						# to supply the merged alignment zones and stem widths for
-						# the final font.
-						finalFDict = fdDict
-					else:
-						# save dict and FDIndex.
-						fdIndexDict[dictName] = len(fontDictList)
-						fontDictList.append(fdDict)
+					dictValues = []
+					items.append((kFDDictToken, dictName, dictValues))
 					
 				elif token == kGlyphSetToken:
 					state = glyphSetState
 					setName = tokenList[i]
 					i += 1
+					setPatterns = []
+					items.append((kGlyphSetToken, setName, setPatterns))
 				else:
 					raise FontInfoParseError("Unrecognized token after \"begin\" keyword: %s" % (token))
 					
@@ -259,7 +321,7 @@ def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueF
 			dictValueList.append(token)
 			if token[-1] in  ["]",  ")"]:
 				value = " ".join(dictValueList)
-				exec("fdDict.%s = \"%s\"" % (dictKeyWord, value))
+				dictValues.append((dictKeyWord, value))
 				state = dictState # found the last token in the list value.
 
 		elif state == glyphSetState:
@@ -271,31 +333,17 @@ def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueF
 			 	i += 2
 			 	setName = None
 			 else:
-			 	# Need to add matching glyphs.
-			 	gi = 0
-			 	for gname in glyphList:
-			 		if re.search(token, gname):
-			 			fdGlyphDict[gname] = [fdIndexDict[setName], gi] # fdIndex value
-			 		gi += 1
+			 	# Glyphs matching the pattern are added to the set.
+			 	setPatterns.append(token)
 			 	
 		elif state == dictState:
 			# "end FDDict" marks end of set, else we are adding a new glyph name.
 			if (token == kEndToken) and tokenList[i] == kFDDictToken:
 				if tokenList[i+1] != dictName:
 					raise FontInfoParseError("End FDDict  name \"%s\" does not match begin FDDict name \"%s\"." % ( tokenList[i+1], dictName))
-				if fdDict.DominantH == None:
-					print("Warning: the FDDict '%s' in fontinfo has no DominantH value" % (dictName))
-				if fdDict.DominantV == None:
-					print("Warning: the FDDict '%s' in fontinfo has no DominantV value" % (dictName))
-				if (fdDict.BlueFuzz == None):
-					fdDict.BlueFuzz = blueFuzz
-				fdDict.buildBlueLists()
-				if fdDict.FontName == None:
-					fdDict.FontName = fontName
 				state = baseState
 				i += 2
 				dictName = None
-				fdDict = None
 			else:
 				if token in kFDDictKeys:
 					value = tokenList[i]
@@ -305,9 +353,80 @@ def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueF
 						dictValueList = [value]
 						dictKeyWord = token
 					else:
-			 			exec("fdDict.%s = \"%s\"" % (token, value))
+			 			dictValues.append((token, value))
 				else:
 			 		raise FontInfoParseError("FDDict key \"%s\" in fdDict named \"%s\" is not recognised." % ( token, dictName))
+
+	if state == dictState:
+		# The last FDDict was not ended, so it is not finished below.
+		items[-1] = (None,) + items[-1][1:]
+
+	fontInfoData = FontInfoData(items)
+	fontInfoCache[key] = fontInfoData
+	return fontInfoData
+
+
+def parseFontInfoFile(fontDictList, data, glyphList, maxY, minY, fontName, blueFuzz):
+	# fontDictList may or may not already contain a font dict taken from the source font top FontDict.
+	fdGlyphDict = {} # The map of glyph names to font dict: the index into fontDictList.
+	finalFDict = None # The user-specified set of blue values to write into the output font, some sort of merge of the individual font dicts. May not be supplied.
+
+	fontInfoData = parseFontInfoData(data)
+	fdIndexDict = {}
+	patternIndexList = [] # FDDict index of each glyph set pattern, as defined where the set begins.
+	lenSrcFontDictList = len(fontDictList)
+
+	for itemType, itemName, itemValues in fontInfoData.items:
+		if itemType == kGlyphSetToken:
+			patternIndexList.extend([(itemName, fdIndexDict.get(itemName))] * len(itemValues))
+			continue
+
+		dictName = itemName
+		fdDict = FDDict()
+		fdDict.DictName = dictName
+		if dictName == kFinalDictName:
+			# This is dict is NOT used to hint any glyphs; it is used
+			# to supply the merged alignment zones and stem widths for
+			# the final font.
+			finalFDict = fdDict
+		else:
+			# save dict and FDIndex.
+			fdIndexDict[dictName] = len(fontDictList)
+			fontDictList.append(fdDict)
+		for key, value in itemValues:
+			exec("fdDict.%s = \"%s\"" % (key, value))
+		if itemType == None:
+			continue # never ended.
+		if fdDict.DominantH == None:
+			print("Warning: the FDDict '%s' in fontinfo has no DominantH value" % (dictName))
+		if fdDict.DominantV == None:
+			print("Warning: the FDDict '%s' in fontinfo has no DominantV value" % (dictName))
+		if (fdDict.BlueFuzz == None):
+			fdDict.BlueFuzz = blueFuzz
+		fdDict.buildBlueLists()
+		if fdDict.FontName == None:
+			fdDict.FontName = fontName
+
+	# Each glyph goes to the set of the last pattern that matches its name.
+	if patternIndexList:
+		# A glyph matching a set that has no FDDict yet is an error, even
+		# when a later pattern also matches it.
+		patterns = fontInfoData.getMatchers()[1]
+		undefinedPatterns = []
+		for pi in range(len(patterns)):
+			setName, fdIndex = patternIndexList[pi]
+			if fdIndex == None:
+				undefinedPatterns.append((patterns[pi][0], setName))
+		gi = 0
+		for gname in glyphList:
+			for pattern, setName in undefinedPatterns:
+				if re.search(pattern, gname):
+					raise KeyError(setName)
+			patternIndex = fontInfoData.matchGlyph(gname)
+			if patternIndex != None:
+				fdIndex = patternIndexList[patternIndex][1]
+				fdGlyphDict[gname] = [fdIndex, gi] # fdIndex value
+			gi += 1
 			 	
 	if lenSrcFontDictList != len(fontDictList):
 		# There are some FDDict definitions. This means that we need to fix the default fontDict, inherited from the source font,
@@ -18,6 +18,7 @@
 #define PY_SSIZE_T_CLEAN 1
 #include <Python.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,13 +72,45 @@ memoryManager(void* ctx, void* ptr, size_t size)
 }
 
 static PyObject* PsAutoHintError;
+static PyObject* PsAutoHintTimeout;
+
+/* Gets a null terminated string from an object supporting the buffer
+ * protocol, which view must be released with PyBuffer_Release once done. The
+ * library only takes null terminated strings: bytes and bytearray objects are
+ * always terminated past their length, so they, and buffers holding a
+ * terminator, are used in place; anything else is copied to *scratch, which
+ * is grown as needed and can be reused for the next string. */
+static const char*
+getString(PyObject* obj, Py_buffer* view, char** scratch, size_t* scratchSize)
+{
+    if (PyObject_GetBuffer(obj, view, PyBUF_SIMPLE) != 0)
+        return NULL;
+
+    if (PyBytes_Check(obj) || PyByteArray_Check(obj) ||
+        memchr(view->buf, '\0', view->len) != NULL)
+        return view->buf;
+
+    if (*scratchSize < (size_t)view->len + 1) {
+        char* newScratch = MEMRENEW(*scratch, view->len + 1);
+        if (!newScratch) {
+            PyBuffer_Release(view);
+            PyErr_NoMemory();
+            return NULL;
+        }
+        *scratch = newScratch;
+        *scratchSize = view->len + 1;
+    }
+    memcpy(*scratch, view->buf, view->len);
+    (*scratch)[view->len] = '\0';
+    return *scratch;
+}
 
 static char autohint_doc[] =
   "Autohint glyphs.\n"
   "\n"
   "Signature:\n"
   "  autohint(font_info, glyphs[, verbose, no_edit, allow_hint_sub, "
-  "round, debug])\n"
+  "round, debug, draft, time_limit, memory_limit])\n"
   "\n"
   "Args:\n"
   "  font_info: font information.\n"
@@ -87,11 +120,22 @@ static char autohint_doc[] =
   "  allow_hint_sub: no multiple layers of coloring.\n"
   "  round: round coordinates.\n"
   "  debug: print debug messages.\n"
+  "  draft: make quicker, coarser hints, without hint substitution, flex\n"
+  "    or any of the refinement passes.\n"
+  "  time_limit: processor time in seconds allowed for hinting each glyph,\n"
+  "    or 0 for no limit.\n"
+  "  memory_limit: bytes of memory allowed for hinting each glyph, or 0 for\n"
+  "    no limit.\n"
+  "\n"
+  "  font_info and the glyph data can be bytes or any other object\n"
+  "  supporting the buffer protocol, such as bytearray, memoryview or mmap.\n"
   "\n"
   "Output:\n"
   "  Sequence of autohinted glyph data in bez format.\n"
   "\n"
   "Raises:\n"
+  "  psautohint.timeout: If a glyph takes longer than time_limit.\n"
+  "  MemoryError: If a glyph needs more memory than memory_limit.\n"
   "  psautohint.error: If authinting fails.\n";
 
 static PyObject*
@@ -100,26 +144,41 @@ autohint(PyObject* self, PyObject* args)
     int allowEdit = true, roundCoords = true, allowHintSub = true;
     int verbose = true;
     int debug = false;
+    int draft = false;
+    double timeLimit = 0;
+    Py_ssize_t memoryLimit = 0;
     PyObject* inSeq = NULL;
     PyObject* fontObj = NULL;
     PyObject* outSeq = NULL;
     int bezLen = 0;
-    char* fontInfo = NULL;
+    Py_buffer fontView;
+    const char* fontInfo = NULL;
+    char* fontScratch = NULL;
+    size_t fontScratchSize = 0;
+    char* scratch = NULL;
+    size_t scratchSize = 0;
     bool error = false;
 
-    if (!PyArg_ParseTuple(args, "O!O|iiiii", &PyBytes_Type, &fontObj, &inSeq,
-                          &verbose, &allowEdit, &allowHintSub, &roundCoords,
-                          &debug))
+    if (!PyArg_ParseTuple(args, "OO|iiiiiidn", &fontObj, &inSeq, &verbose,
+                          &allowEdit, &allowHintSub, &roundCoords, &debug,
+                          &draft, &timeLimit, &memoryLimit))
         return NULL;
 
     inSeq = PySequence_Fast(inSeq, "argument must be sequence");
     if (!inSeq)
         return NULL;
 
-    fontInfo = PyBytes_AsString(fontObj);
+    fontInfo = getString(fontObj, &fontView, &fontScratch, &fontScratchSize);
+    if (!fontInfo) {
+        Py_DECREF(inSeq);
+        return NULL;
+    }
 
     AC_SetMemManager(NULL, memoryManager);
     AC_SetReportCB(reportCB, verbose);
+    AC_SetTimeLimit(timeLimit);
+    AC_SetMemoryLimit(memoryLimit > 0 ? (size_t)memoryLimit : 0);
+    AC_SetDraftMode(draft);
 
     bezLen = PySequence_Fast_GET_SIZE(inSeq);
     outSeq = PyTuple_New(bezLen);
@@ -128,40 +187,60 @@ autohint(PyObject* self, PyObject* args)
     } else {
         int i = 0;
         for (i = 0; i < bezLen; i++) {
-            char* bezData = NULL;
-            char* output = NULL;
+            Py_buffer bezView;
+            const char* bezData = NULL;
+            PyObject* bezObj = NULL;
             size_t outputSize = 0;
             int result;
 
             PyObject* itemObj = PySequence_Fast_GET_ITEM(inSeq, i);
 
-            bezData = PyBytes_AsString(itemObj);
+            bezData = getString(itemObj, &bezView, &scratch, &scratchSize);
             if (!bezData) {
                 error = true;
                 break;
             }
 
-            outputSize = 4 * strlen(bezData);
-            output = MEMNEW(outputSize);
+            /* The library writes the output straight into the bytes object,
+             * which is then shrunk to the actual size. */
+            outputSize = 4 * bezView.len;
+            bezObj = PyBytes_FromStringAndSize(NULL, outputSize);
+            if (!bezObj) {
+                PyBuffer_Release(&bezView);
+                error = true;
+                break;
+            }
 
-            result =
-              AutoColorString(bezData, fontInfo, output, &outputSize, allowEdit,
-                              allowHintSub, roundCoords, debug);
+            result = AutoColorString(bezData, fontInfo,
+                                     PyBytes_AS_STRING(bezObj), &outputSize,
+                                     allowEdit, allowHintSub, roundCoords,
+                                     debug);
             if (result == AC_DestBuffOfloError) {
-                output = MEMRENEW(output, outputSize);
+                if (_PyBytes_Resize(&bezObj, outputSize) != 0) {
+                    PyBuffer_Release(&bezView);
+                    error = true;
+                    break;
+                }
                 AC_SetReportCB(reportCB, false);
-                result =
-                  AutoColorString(bezData, fontInfo, output, &outputSize,
-                                  allowEdit, allowHintSub, roundCoords, debug);
+                result = AutoColorString(bezData, fontInfo,
+                                         PyBytes_AS_STRING(bezObj),
+                                         &outputSize, allowEdit, allowHintSub,
+                                         roundCoords, debug);
                 AC_SetReportCB(reportCB, verbose);
             }
+            PyBuffer_Release(&bezView);
 
             if (outputSize != 0 && result == AC_Success) {
-                PyObject* bezObj = PyBytes_FromString(output);
+                /* outputSize includes the terminator. */
+                if (_PyBytes_Resize(&bezObj, outputSize - 1) != 0) {
+                    error = true;
+                    break;
+                }
                 PyTuple_SET_ITEM(outSeq, i, bezObj);
+            } else {
+                Py_DECREF(bezObj);
             }
 
-            MEMFREE(output);
             if (result != AC_Success) {
                 switch (result) {
                     case AC_FontinfoParseFail:
@@ -183,6 +262,10 @@ autohint(PyObject* self, PyObject* args)
                     case AC_InvalidParameterError:
                         PyErr_SetString(PyExc_ValueError, "Invalid glyph data");
                         break;
+                    case AC_CancelledError:
+                        PyErr_SetString(PsAutoHintTimeout,
+                                        "Time limit exceeded");
+                        break;
                 }
                 error = true;
                 break;
@@ -190,7 +273,12 @@ autohint(PyObject* self, PyObject* args)
         }
     }
 
+    AC_SetTimeLimit(0);
+    AC_SetMemoryLimit(0);
     Py_XDECREF(inSeq);
+    PyBuffer_Release(&fontView);
+    MEMFREE(fontScratch);
+    MEMFREE(scratch);
 
     if (error) {
         Py_XDECREF(outSeq);
@@ -200,9 +288,2776 @@ autohint(PyObject* self, PyObject* args)
     return outSeq;
 }
 
+static char autohintmm_doc[] =
+  "Autohint the masters of a glyph together.\n"
+  "\n"
+  "Signature:\n"
+  "  autohintmm(font_info, masters[, verbose, allow_hint_sub, round, "
+  "debug])\n"
+  "\n"
+  "Args:\n"
+  "  font_info: font information.\n"
+  "  masters: sequence of the masters of one glyph in bez format, which\n"
+  "    must all have the same path elements.\n"
+  "  verbose: print verbose messages.\n"
+  "  allow_hint_sub: no multiple layers of coloring.\n"
+  "  round: round coordinates.\n"
+  "  debug: print debug messages.\n"
+  "\n"
+  "  The first master is hinted without editing its path, and its hints are\n"
+  "  moved to the matching path elements of the other masters, so that all\n"
+  "  of them get the same hints and hint substitutions.\n"
+  "\n"
+  "Output:\n"
+  "  Sequence of autohinted masters in bez format.\n"
+  "\n"
+  "Raises:\n"
+  "  psautohint.error: If authinting fails.\n"
+  "  ValueError: If the masters are not compatible.\n";
+
+static PyObject*
+autohintmm(PyObject* self, PyObject* args)
+{
+    int allowHintSub = true, roundCoords = true;
+    int verbose = true;
+    int debug = false;
+    PyObject* inSeq = NULL;
+    PyObject* fontObj = NULL;
+    PyObject* outSeq = NULL;
+    Py_ssize_t masterCount = 0, i, viewCount = 0;
+    Py_buffer fontView;
+    Py_buffer* views = NULL;
+    const char* fontInfo = NULL;
+    const char** masters = NULL;
+    char** outputs = NULL;
+    size_t* lengths = NULL;
+    char* scratch = NULL;
+    size_t scratchSize = 0;
+    char** scratches = NULL;
+    size_t* scratchSizes = NULL;
+    int result = AC_Success;
+
+    if (!PyArg_ParseTuple(args, "OO|iiii", &fontObj, &inSeq, &verbose,
+                          &allowHintSub, &roundCoords, &debug))
+        return NULL;
+
+    inSeq = PySequence_Fast(inSeq, "argument must be sequence");
+    if (!inSeq)
+        return NULL;
+
+    masterCount = PySequence_Fast_GET_SIZE(inSeq);
+    if (masterCount == 0) {
+        Py_DECREF(inSeq);
+        return PyTuple_New(0);
+    }
+
+    fontInfo = getString(fontObj, &fontView, &scratch, &scratchSize);
+    if (!fontInfo) {
+        Py_DECREF(inSeq);
+        return NULL;
+    }
+
+    views = MEMNEW(masterCount * sizeof(Py_buffer));
+    masters = MEMNEW(masterCount * sizeof(char*));
+    outputs = MEMNEW(masterCount * sizeof(char*));
+    lengths = MEMNEW(masterCount * sizeof(size_t));
+    scratches = MEMNEW(masterCount * sizeof(char*));
+    scratchSizes = MEMNEW(masterCount * sizeof(size_t));
+    if (!views || !masters || !outputs || !lengths || !scratches ||
+        !scratchSizes) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    memset(outputs, 0, masterCount * sizeof(char*));
+    memset(scratches, 0, masterCount * sizeof(char*));
+    memset(scratchSizes, 0, masterCount * sizeof(size_t));
+
+    for (i = 0; i < masterCount; i++) {
+        PyObject* itemObj = PySequence_Fast_GET_ITEM(inSeq, i);
+        masters[i] = getString(itemObj, &views[i], &scratches[i],
+                               &scratchSizes[i]);
+        if (!masters[i])
+            goto done;
+        viewCount++;
+        lengths[i] = 4 * views[i].len + 1;
+        outputs[i] = MEMNEW(lengths[i]);
+        if (!outputs[i]) {
+            PyErr_NoMemory();
+            goto done;
+        }
+    }
+
+    AC_SetMemManager(NULL, memoryManager);
+    AC_SetReportCB(reportCB, verbose);
+
+    result = AutoColorStringMM(masters, fontInfo, masterCount, outputs,
+                               lengths, allowHintSub, roundCoords, debug);
+    if (result == AC_DestBuffOfloError) {
+        for (i = 0; i < masterCount; i++) {
+            char* output = MEMRENEW(outputs[i], lengths[i]);
+            if (!output) {
+                PyErr_NoMemory();
+                goto done;
+            }
+            outputs[i] = output;
+        }
+        AC_SetReportCB(reportCB, false);
+        result = AutoColorStringMM(masters, fontInfo, masterCount, outputs,
+                                   lengths, allowHintSub, roundCoords, debug);
+        AC_SetReportCB(reportCB, verbose);
+    }
+
+    switch (result) {
+        case AC_Success:
+            outSeq = PyTuple_New(masterCount);
+            if (!outSeq)
+                break;
+            for (i = 0; i < masterCount; i++) {
+                PyObject* bezObj = PyBytes_FromString(outputs[i]);
+                if (!bezObj) {
+                    Py_CLEAR(outSeq);
+                    break;
+                }
+                PyTuple_SET_ITEM(outSeq, i, bezObj);
+            }
+            break;
+        case AC_FontinfoParseFail:
+            PyErr_SetString(PsAutoHintError, "Parsing font info failed");
+            break;
+        case AC_FatalError:
+            PyErr_SetString(PsAutoHintError, "Fatal error");
+            break;
+        case AC_MemoryError:
+            PyErr_NoMemory();
+            break;
+        case AC_DestBuffOfloError:
+            PyErr_SetString(PsAutoHintError, "Dest buffer small");
+            break;
+        case AC_InvalidParameterError:
+            PyErr_SetString(PyExc_ValueError, "Incompatible masters");
+            break;
+        default:
+            PyErr_SetString(PsAutoHintError, "Hinting failed");
+            break;
+    }
+
+done:
+    for (i = 0; i < viewCount; i++)
+        PyBuffer_Release(&views[i]);
+    for (i = 0; i < masterCount; i++) {
+        if (outputs)
+            MEMFREE(outputs[i]);
+        if (scratches)
+            MEMFREE(scratches[i]);
+    }
+    MEMFREE(views);
+    MEMFREE(masters);
+    MEMFREE(outputs);
+    MEMFREE(lengths);
+    MEMFREE(scratches);
+    MEMFREE(scratchSizes);
+    Py_DECREF(inSeq);
+    PyBuffer_Release(&fontView);
+    MEMFREE(scratch);
+
+    return outSeq;
+}
+
+static char memory_stats_doc[] =
+  "Get the memory used by the last glyph hinted.\n"
+  "\n"
+  "Signature:\n"
+  "  memory_stats()\n"
+  "\n"
+  "Output:\n"
+  "  Tuple of the number of allocations made for the last glyph hinted by\n"
+  "  autohint() or autohintmm(), or the last call to stem_histograms() or\n"
+  "  derive_fontinfo(), the bytes they asked for, the most bytes allocated\n"
+  "  at once and the most bytes of the fixed size arena for hints used.\n";
+
+static PyObject*
+memory_stats(PyObject* self, PyObject* args)
+{
+    AC_MemoryStats stats;
+
+    AC_GetMemoryStats(&stats);
+    return Py_BuildValue("(nnnn)", (Py_ssize_t)stats.allocCount,
+                         (Py_ssize_t)stats.allocBytes,
+                         (Py_ssize_t)stats.peakBytes,
+                         (Py_ssize_t)stats.arenaPeak);
+}
+
+static char stem_histograms_doc[] =
+  "Collect the stem widths of many glyphs.\n"
+  "\n"
+  "Signature:\n"
+  "  stem_histograms(font_info, glyphs[, all_stems])\n"
+  "\n"
+  "Args:\n"
+  "  font_info: font information.\n"
+  "  glyphs: sequence of glyph data in bez format.\n"
+  "  all_stems: include stems between curved segments.\n"
+  "\n"
+  "Output:\n"
+  "  Tuple of four histograms: straight horizontal, curved horizontal,\n"
+  "  straight vertical and curved vertical stems. Each is a tuple of\n"
+  "  (width, stem count, glyph count) tuples sorted by width.\n"
+  "\n"
+  "Raises:\n"
+  "  psautohint.error: If parsing the font info fails.\n";
+
+static PyObject*
+histogramToTuple(AC_StemHistogram* histogram)
+{
+    size_t i;
+    PyObject* histObj = PyTuple_New(histogram->length);
+    if (!histObj)
+        return NULL;
+
+    for (i = 0; i < histogram->length; i++) {
+        AC_StemWidthCount* width = &histogram->widths[i];
+        PyObject* widthObj = Py_BuildValue("(dii)", width->width / 256.0,
+                                           width->count, width->glyphCount);
+        if (!widthObj) {
+            Py_DECREF(histObj);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(histObj, i, widthObj);
+    }
+
+    return histObj;
+}
+
+static PyObject*
+stem_histograms(PyObject* self, PyObject* args)
+{
+    int allStems = false;
+    PyObject* inSeq = NULL;
+    PyObject* fontObj = NULL;
+    PyObject* outObj = NULL;
+    Py_ssize_t i, bezLen = 0;
+    const char** bezData = NULL;
+    AC_StemHistograms histograms;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "O!O|i", &PyBytes_Type, &fontObj, &inSeq,
+                          &allStems))
+        return NULL;
+
+    inSeq = PySequence_Fast(inSeq, "argument must be sequence");
+    if (!inSeq)
+        return NULL;
+
+    bezLen = PySequence_Fast_GET_SIZE(inSeq);
+    bezData = MEMNEW((bezLen + 1) * sizeof(char*));
+    if (!bezData) {
+        Py_DECREF(inSeq);
+        return PyErr_NoMemory();
+    }
+
+    for (i = 0; i < bezLen; i++) {
+        bezData[i] = PyBytes_AsString(PySequence_Fast_GET_ITEM(inSeq, i));
+        if (!bezData[i]) {
+            MEMFREE(bezData);
+            Py_DECREF(inSeq);
+            return NULL;
+        }
+    }
+
+    AC_SetMemManager(NULL, memoryManager);
+    AC_SetReportCB(reportCB, false);
+
+    result = AC_GetStemHistograms(PyBytes_AsString(fontObj), bezData, bezLen,
+                                  allStems, &histograms);
+
+    MEMFREE(bezData);
+    Py_DECREF(inSeq);
+
+    switch (result) {
+        case AC_Success:
+            break;
+        case AC_FontinfoParseFail:
+            PyErr_SetString(PsAutoHintError, "Parsing font info failed");
+            return NULL;
+        case AC_MemoryError:
+            return PyErr_NoMemory();
+        default:
+            PyErr_SetString(PsAutoHintError, "Stem analysis failed");
+            return NULL;
+    }
+
+    outObj = PyTuple_New(4);
+    for (i = 0; outObj && i < 4; i++) {
+        AC_StemHistogram* histogram =
+          i == 0 ? &histograms.hStraight
+                 : i == 1 ? &histograms.hCurved
+                          : i == 2 ? &histograms.vStraight
+                                   : &histograms.vCurved;
+        PyObject* histObj = histogramToTuple(histogram);
+        if (!histObj) {
+            Py_CLEAR(outObj);
+            break;
+        }
+        PyTuple_SET_ITEM(outObj, i, histObj);
+    }
+    AC_FreeStemHistograms(&histograms);
+
+    return outObj;
+}
+
+static char derive_fontinfo_doc[] =
+  "Derive font information from the glyphs of a font.\n"
+  "\n"
+  "Signature:\n"
+  "  derive_fontinfo(glyphs, units_per_em)\n"
+  "\n"
+  "Args:\n"
+  "  glyphs: sequence of glyph data in bez format.\n"
+  "  units_per_em: units per em of the font.\n"
+  "\n"
+  "Output:\n"
+  "  Font information with the alignment zones and stem widths found.\n"
+  "\n"
+  "Raises:\n"
+  "  psautohint.error: If the analysis fails.\n";
+
+static PyObject*
+derive_fontinfo(PyObject* self, PyObject* args)
+{
+    int unitsPerEm = 0;
+    PyObject* inSeq = NULL;
+    PyObject* outObj = NULL;
+    Py_ssize_t i, bezLen = 0;
+    const char** bezData = NULL;
+    char* output = NULL;
+    size_t outputSize = 1024;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "Oi", &inSeq, &unitsPerEm))
+        return NULL;
+
+    inSeq = PySequence_Fast(inSeq, "argument must be sequence");
+    if (!inSeq)
+        return NULL;
+
+    bezLen = PySequence_Fast_GET_SIZE(inSeq);
+    bezData = MEMNEW((bezLen + 1) * sizeof(char*));
+    if (!bezData) {
+        Py_DECREF(inSeq);
+        return PyErr_NoMemory();
+    }
+
+    for (i = 0; i < bezLen; i++) {
+        bezData[i] = PyBytes_AsString(PySequence_Fast_GET_ITEM(inSeq, i));
+        if (!bezData[i]) {
+            MEMFREE(bezData);
+            Py_DECREF(inSeq);
+            return NULL;
+        }
+    }
+
+    AC_SetMemManager(NULL, memoryManager);
+    AC_SetReportCB(reportCB, false);
+
+    output = MEMNEW(outputSize);
+    result = AC_DeriveFontInfo(bezData, bezLen, unitsPerEm, output, &outputSize);
+    if (result == AC_DestBuffOfloError) {
+        output = MEMRENEW(output, outputSize);
+        result =
+          AC_DeriveFontInfo(bezData, bezLen, unitsPerEm, output, &outputSize);
+    }
+
+    MEMFREE(bezData);
+    Py_DECREF(inSeq);
+
+    switch (result) {
+        case AC_Success:
+            outObj = PyBytes_FromString(output);
+            break;
+        case AC_MemoryError:
+            PyErr_NoMemory();
+            break;
+        case AC_InvalidParameterError:
+            PyErr_SetString(PyExc_ValueError, "Invalid units per em");
+            break;
+        default:
+            PyErr_SetString(PsAutoHintError, "Font info derivation failed");
+            break;
+    }
+    MEMFREE(output);
+
+    return outObj;
+}
+
+/* GLIF to bez conversion.
+ *
+ * This follows ufoTools.convertGlyphOutlineToBezString exactly, down to the
+ * transform arithmetic, the rounding and where line separators go, but reads
+ * the GLIF data with a small XML tokenizer instead of walking ElementTree
+ * nodes. Anything it does not handle, including all the invalid outlines the
+ * Python code reports errors for, makes it return None so that the caller can
+ * fall back to the Python code. */
+
+#ifdef _WIN32
+#define LINESEP "\r\n"
+#else
+#define LINESEP "\n"
+#endif
+
+/* The transforms must round like the Python code does, without fused
+ * multiply-adds. */
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+#define MAX_GLIF_ATTRIBUTES 16
+#define MAX_COMPONENT_LEVEL 10
+#define MAX_GLIF_COORD 1e9
+
+/* Results of the conversion functions below. */
+#define GLIF_OK 1
+#define GLIF_UNSUPPORTED 0
+#define GLIF_ERROR -1
+
+typedef struct
+{
+    const char* name;
+    size_t nameLength;
+    const char* value;
+    size_t valueLength;
+} GlifAttribute;
+
+typedef struct
+{
+    const char* name;
+    size_t nameLength;
+    GlifAttribute attributes[MAX_GLIF_ATTRIBUTES];
+    int attributeCount;
+    bool isEnd;   /* </name> */
+    bool isEmpty; /* <name/> */
+} GlifTag;
+
+typedef struct
+{
+    const char* pos;
+    const char* end;
+} GlifParser;
+
+typedef struct
+{
+    double factors[6];
+    bool isDefault;
+    bool isOffsetOnly;
+} GlifTransform;
+
+enum
+{
+    kGlifMove,
+    kGlifLine,
+    kGlifOffCurve,
+    kGlifCurve
+};
+
+typedef struct
+{
+    double x, y;
+    int type;
+} GlifPoint;
+
+typedef struct
+{
+    char* data;
+    size_t length;
+    size_t capacity;
+    GlifPoint* points;
+    size_t pointCapacity;
+    PyObject* getComponent;
+    bool allowDecimals;
+} BezWriter;
+
+static bool
+isXMLSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool
+isXMLNameEnd(char c)
+{
+    return isXMLSpace(c) || c == '=' || c == '>' || c == '/';
+}
+
+static const char*
+findText(const char* pos, const char* end, const char* text)
+{
+    size_t length = strlen(text);
+    for (; pos + length <= end; pos++) {
+        if (memcmp(pos, text, length) == 0)
+            return pos;
+    }
+    return NULL;
+}
+
+/* Reads the next start or end tag, skipping text, comments and processing
+ * instructions. Returns GLIF_OK with a tag, or GLIF_UNSUPPORTED at the end of
+ * the data or on anything else. */
+static int
+nextTag(GlifParser* parser, GlifTag* tag)
+{
+    const char* pos = parser->pos;
+    const char* end = parser->end;
+
+    for (;;) {
+        pos = memchr(pos, '<', end - pos);
+        if (pos == NULL || end - pos < 2)
+            return GLIF_UNSUPPORTED;
+        if (pos[1] == '?') {
+            pos = findText(pos + 2, end, "?>");
+            if (pos == NULL)
+                return GLIF_UNSUPPORTED;
+            pos += 2;
+        } else if (end - pos >= 4 && memcmp(pos, "<!--", 4) == 0) {
+            pos = findText(pos + 4, end, "-->");
+            if (pos == NULL)
+                return GLIF_UNSUPPORTED;
+            pos += 3;
+        } else if (pos[1] == '!') {
+            /* DOCTYPE and CDATA. */
+            return GLIF_UNSUPPORTED;
+        } else {
+            break;
+        }
+    }
+
+    pos++;
+    tag->isEnd = *pos == '/';
+    tag->isEmpty = false;
+    tag->attributeCount = 0;
+    if (tag->isEnd)
+        pos++;
+    tag->name = pos;
+    while (pos < end && !isXMLNameEnd(*pos))
+        pos++;
+    tag->nameLength = pos - tag->name;
+    if (tag->nameLength == 0)
+        return GLIF_UNSUPPORTED;
+
+    for (;;) {
+        GlifAttribute* attribute;
+        char quote;
+        while (pos < end && isXMLSpace(*pos))
+            pos++;
+        if (pos >= end)
+            return GLIF_UNSUPPORTED;
+        if (*pos == '>') {
+            pos++;
+            break;
+        }
+        if (*pos == '/' && !tag->isEnd && end - pos >= 2 && pos[1] == '>') {
+            tag->isEmpty = true;
+            pos += 2;
+            break;
+        }
+        if (tag->isEnd || tag->attributeCount == MAX_GLIF_ATTRIBUTES)
+            return GLIF_UNSUPPORTED;
+
+        attribute = &tag->attributes[tag->attributeCount++];
+        attribute->name = pos;
+        while (pos < end && !isXMLNameEnd(*pos))
+            pos++;
+        attribute->nameLength = pos - attribute->name;
+        /* Namespaces change the tag names ElementTree reports. */
+        if (attribute->nameLength == 0 ||
+            (attribute->nameLength >= 5 &&
+             memcmp(attribute->name, "xmlns", 5) == 0))
+            return GLIF_UNSUPPORTED;
+        while (pos < end && isXMLSpace(*pos))
+            pos++;
+        if (pos >= end || *pos != '=')
+            return GLIF_UNSUPPORTED;
+        pos++;
+        while (pos < end && isXMLSpace(*pos))
+            pos++;
+        if (pos >= end || (*pos != '"' && *pos != '\''))
+            return GLIF_UNSUPPORTED;
+        quote = *pos++;
+        attribute->value = pos;
+        while (pos < end && *pos != quote) {
+            /* Entity references would need decoding. */
+            if (*pos == '&' || *pos == '<')
+                return GLIF_UNSUPPORTED;
+            pos++;
+        }
+        if (pos >= end)
+            return GLIF_UNSUPPORTED;
+        attribute->valueLength = pos - attribute->value;
+        pos++;
+    }
+
+    parser->pos = pos;
+    return GLIF_OK;
+}
+
+static bool
+isTag(const GlifTag* tag, const char* name)
+{
+    return tag->nameLength == strlen(name) &&
+           memcmp(tag->name, name, tag->nameLength) == 0;
+}
+
+static const GlifAttribute*
+getAttribute(const GlifTag* tag, const char* name)
+{
+    int i;
+    size_t length = strlen(name);
+    for (i = 0; i < tag->attributeCount; i++) {
+        const GlifAttribute* attribute = &tag->attributes[i];
+        if (attribute->nameLength == length &&
+            memcmp(attribute->name, name, length) == 0)
+            return attribute;
+    }
+    return NULL;
+}
+
+static bool
+isAttribute(const GlifAttribute* attribute, const char* value)
+{
+    return attribute->valueLength == strlen(value) &&
+           memcmp(attribute->value, value, attribute->valueLength) == 0;
+}
+
+/* Parses a number the way float() does, but only in the plain forms that
+ * PyOS_string_to_double and float() agree on. */
+static bool
+parseNumber(const GlifAttribute* attribute, double* value)
+{
+    char text[64];
+    char* endptr;
+    size_t i;
+
+    if (attribute->valueLength == 0 || attribute->valueLength >= sizeof(text))
+        return false;
+    for (i = 0; i < attribute->valueLength; i++) {
+        char c = attribute->value[i];
+        if (!((c >= '0' && c <= '9') || c == '.' || c == '-' || c == '+' ||
+              c == 'e' || c == 'E'))
+            return false;
+    }
+    memcpy(text, attribute->value, attribute->valueLength);
+    text[attribute->valueLength] = '\0';
+
+    *value = PyOS_string_to_double(text, &endptr, NULL);
+    if (*value == -1.0 && PyErr_Occurred()) {
+        PyErr_Clear();
+        return false;
+    }
+    return *endptr == '\0';
+}
+
+/* Skips the content of the element started by tag, checking that it nests
+ * properly. */
+static int
+skipElement(GlifParser* parser, const GlifTag* tag)
+{
+    GlifTag child;
+    if (tag->isEmpty)
+        return GLIF_OK;
+    for (;;) {
+        if (nextTag(parser, &child) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+        if (child.isEnd) {
+            if (child.nameLength != tag->nameLength ||
+                memcmp(child.name, tag->name, tag->nameLength) != 0)
+                return GLIF_UNSUPPORTED;
+            return GLIF_OK;
+        }
+        if (skipElement(parser, &child) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+    }
+}
+
+/* Finds the outline element of a GLIF, leaving the parser after its start tag.
+ * Returns GLIF_OK and sets *found to false if there is none. */
+static int
+findOutline(GlifParser* parser, GlifTag* outline, bool* found)
+{
+    GlifTag root;
+
+    *found = false;
+    if (nextTag(parser, &root) != GLIF_OK || root.isEnd)
+        return GLIF_UNSUPPORTED;
+    if (root.isEmpty)
+        return GLIF_OK;
+    for (;;) {
+        if (nextTag(parser, outline) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+        if (outline->isEnd)
+            return GLIF_OK;
+        if (isTag(outline, "outline")) {
+            *found = true;
+            return GLIF_OK;
+        }
+        if (skipElement(parser, outline) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+    }
+}
+
+static bool
+writeText(BezWriter* writer, const char* text, size_t length)
+{
+    if (writer->length + length + 1 > writer->capacity) {
+        size_t capacity = 2 * writer->capacity + length + 1;
+        char* data = MEMRENEW(writer->data, capacity);
+        if (!data) {
+            PyErr_NoMemory();
+            return false;
+        }
+        writer->data = data;
+        writer->capacity = capacity;
+    }
+    memcpy(writer->data + writer->length, text, length);
+    writer->length += length;
+    writer->data[writer->length] = '\0';
+    return true;
+}
+
+/* The Python code joins the items of each outline with line separators. */
+static bool
+startItem(BezWriter* writer, int* items)
+{
+    if ((*items)++ > 0)
+        return writeText(writer, LINESEP, strlen(LINESEP));
+    return true;
+}
+
+static double
+roundCoord(double value)
+{
+#if PY_MAJOR_VERSION >= 3
+    /* Same as round() in Python 3, which rounds halves to even. */
+    double rounded = round(value);
+    if (fabs(value - rounded) == 0.5)
+        rounded = 2.0 * round(value / 2.0);
+    return rounded;
+#else
+    return round(value);
+#endif
+}
+
+static bool
+transformPoint(const BezWriter* writer, const GlifTransform* transform,
+               const GlifPoint* point, double* x, double* y)
+{
+    *x = point->x;
+    *y = point->y;
+    if (transform) {
+        const double* factors = transform->factors;
+        if (transform->isOffsetOnly) {
+            *x += factors[4];
+            *y += factors[5];
+        } else {
+            double newX = *x * factors[0] + *y * factors[2] + factors[4];
+            double newY = *x * factors[1] + *y * factors[3] + factors[5];
+            *x = newX;
+            *y = newY;
+        }
+    }
+    if (!writer->allowDecimals) {
+        *x = roundCoord(*x);
+        *y = roundCoord(*y);
+    }
+    return fabs(*x) < MAX_GLIF_COORD && fabs(*y) < MAX_GLIF_COORD;
+}
+
+static bool
+writeOp(BezWriter* writer, int* items, const double* args, int count,
+        const char* op)
+{
+    char text[256];
+    int i, length = 0;
+
+    for (i = 0; i < count; i++) {
+        if (writer->allowDecimals)
+            length += sprintf(text + length, "%.3f ", args[i]);
+        else
+            length += sprintf(text + length, "%ld ", (long)args[i]);
+    }
+    length += sprintf(text + length, "%s", op);
+    return startItem(writer, items) && writeText(writer, text, length);
+}
+
+static void
+initTransform(GlifTransform* transform, const GlifTag* component,
+              bool* supported)
+{
+    static const char* names[6] = { "xScale",  "xyScale", "yxScale",
+                                    "yScale",  "xOffset", "yOffset" };
+    bool hasScale = false, hasOffset = false;
+    int i;
+
+    transform->isDefault = true;
+    transform->isOffsetOnly = true;
+    for (i = 0; i < 6; i++) {
+        const GlifAttribute* attribute = getAttribute(component, names[i]);
+        bool isScale = i == 0 || i == 3;
+        double value = isScale ? 1.0 : 0.0;
+        if (attribute) {
+            if (!parseNumber(attribute, &value))
+                *supported = false;
+            if (isScale) {
+                if (value != 1.0)
+                    hasScale = true;
+            } else if (value != 0) {
+                transform->isDefault = false;
+                if (i == 1 || i == 2)
+                    hasScale = true;
+                else
+                    hasOffset = true;
+            }
+        }
+        transform->factors[i] = value;
+    }
+    if (hasScale || hasOffset)
+        transform->isDefault = false;
+    if (hasScale)
+        transform->isOffsetOnly = false;
+}
+
+static void
+concatTransform(GlifTransform* transform, const GlifTransform* previous)
+{
+    double* cur = transform->factors;
+    const double* prev;
+    double factors[6];
+
+    if (previous == NULL || previous->isDefault)
+        return;
+    prev = previous->factors;
+    if (previous->isOffsetOnly) {
+        cur[4] += prev[4];
+        cur[5] += prev[5];
+        transform->isDefault = false;
+        return;
+    }
+    factors[0] = cur[0] * prev[0] + cur[1] * prev[2];
+    factors[1] = cur[0] * prev[1] + cur[1] * prev[3];
+    factors[2] = cur[2] * prev[0] + cur[3] * prev[2];
+    factors[3] = cur[2] * prev[1] + cur[3] * prev[3];
+    factors[4] = cur[4] * prev[0] + cur[5] * prev[2] + prev[4];
+    factors[5] = cur[4] * prev[1] + cur[5] * prev[3] + prev[5];
+    memcpy(cur, factors, sizeof(factors));
+    transform->isOffsetOnly = transform->isOffsetOnly && previous->isOffsetOnly;
+    transform->isDefault = false;
+}
+
+static int
+readContour(BezWriter* writer, GlifParser* parser, const GlifTag* contour,
+            size_t* count)
+{
+    GlifTag point;
+
+    *count = 0;
+    if (contour->isEmpty)
+        return GLIF_OK;
+    for (;;) {
+        const GlifAttribute *x, *y, *type;
+        GlifPoint* p;
+        if (nextTag(parser, &point) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+        if (point.isEnd)
+            return isTag(&point, "contour") ? GLIF_OK : GLIF_UNSUPPORTED;
+        if (!isTag(&point, "point") || skipElement(parser, &point) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+
+        if (*count == writer->pointCapacity) {
+            size_t capacity = 2 * writer->pointCapacity + 64;
+            GlifPoint* points =
+              MEMRENEW(writer->points, capacity * sizeof(GlifPoint));
+            if (!points) {
+                PyErr_NoMemory();
+                return GLIF_ERROR;
+            }
+            writer->points = points;
+            writer->pointCapacity = capacity;
+        }
+        p = &writer->points[(*count)++];
+
+        x = getAttribute(&point, "x");
+        y = getAttribute(&point, "y");
+        type = getAttribute(&point, "type");
+        if (!x || !y || !parseNumber(x, &p->x) || !parseNumber(y, &p->y))
+            return GLIF_UNSUPPORTED;
+        if (!type || isAttribute(type, "offcurve"))
+            p->type = kGlifOffCurve;
+        else if (isAttribute(type, "move"))
+            p->type = kGlifMove;
+        else if (isAttribute(type, "line"))
+            p->type = kGlifLine;
+        else if (isAttribute(type, "curve"))
+            p->type = kGlifCurve;
+        else
+            return GLIF_UNSUPPORTED;
+    }
+}
+
+static int
+writeContour(BezWriter* writer, int* items, const GlifTransform* transform,
+             size_t count)
+{
+    GlifPoint* points = writer->points;
+    GlifPoint* first = &points[0];
+    GlifPoint* last = &points[count - 1];
+    double args[6];
+    size_t i, start = 0, stop = count;
+    int stack = 0;
+    bool closeWithFirst = false;
+
+    if (first->type == kGlifCurve || first->type == kGlifLine) {
+        /* The first point becomes the move-to, and a curve is moved to the
+         * end, while a line is dropped, as AC behaves differently when a final
+         * line-to is explicit. */
+        start = 1;
+        closeWithFirst = first->type != kGlifLine;
+        if (!transformPoint(writer, transform, first, &args[0], &args[1]) ||
+            !writeOp(writer, items, args, 2, "mt"))
+            return PyErr_Occurred() ? GLIF_ERROR : GLIF_UNSUPPORTED;
+    } else if (first->type == kGlifMove) {
+        /* Most likely left over from a GLIF format 1 anchor. */
+        if (count == 1)
+            return GLIF_OK;
+    } else {
+        /* The move-to goes to the end of the last segment. */
+        if (last->type == kGlifOffCurve)
+            return GLIF_UNSUPPORTED;
+        if (last->type == kGlifLine || last->type == kGlifCurve) {
+            if (!transformPoint(writer, transform, last, &args[0], &args[1]) ||
+                !writeOp(writer, items, args, 2, "mt"))
+                return PyErr_Occurred() ? GLIF_ERROR : GLIF_UNSUPPORTED;
+            if (last->type == kGlifLine)
+                stop = count - 1;
+        }
+    }
+
+    for (i = start; i < stop + (closeWithFirst ? 1 : 0); i++) {
+        GlifPoint* point = i < stop ? &points[i] : first;
+        double x, y;
+        bool ok = true;
+        if (!transformPoint(writer, transform, point, &x, &y))
+            return GLIF_UNSUPPORTED;
+        switch (point->type) {
+            case kGlifOffCurve:
+                if (stack >= 4)
+                    return GLIF_UNSUPPORTED;
+                args[stack++] = x;
+                args[stack++] = y;
+                break;
+            case kGlifMove:
+            case kGlifLine:
+                args[0] = x;
+                args[1] = y;
+                ok = writeOp(writer, items, args, 2,
+                             point->type == kGlifMove ? "mt" : "dt");
+                stack = 0;
+                break;
+            case kGlifCurve:
+                if (stack != 4)
+                    return GLIF_UNSUPPORTED;
+                args[4] = x;
+                args[5] = y;
+                ok = writeOp(writer, items, args, 6, "ct");
+                stack = 0;
+                break;
+        }
+        if (!ok)
+            return GLIF_ERROR;
+    }
+
+    if (!startItem(writer, items) || !writeText(writer, "cp" LINESEP, 2 +
+                                                strlen(LINESEP)))
+        return GLIF_ERROR;
+    return GLIF_OK;
+}
+
+static int writeOutline(BezWriter* writer, GlifParser* parser,
+                        const GlifTransform* transform, int level);
+
+static int
+writeComponent(BezWriter* writer, int* items, const GlifTag* component,
+               const GlifTransform* transform, int level)
+{
+    const GlifAttribute* base = getAttribute(component, "base");
+    GlifTransform newTransform;
+    const GlifTransform* useTransform = &newTransform;
+    PyObject* glifObj;
+    GlifParser parser;
+    GlifTag outline;
+    bool supported = true, found;
+    int result;
+
+    if (!base)
+        return GLIF_UNSUPPORTED;
+    initTransform(&newTransform, component, &supported);
+    if (!supported)
+        return GLIF_UNSUPPORTED;
+    if (newTransform.isDefault && transform == NULL)
+        useTransform = NULL;
+    else
+        concatTransform(&newTransform, transform);
+
+    glifObj = PyObject_CallFunction(writer->getComponent, "s#", base->value,
+                                    (Py_ssize_t)base->valueLength);
+    if (!glifObj)
+        return GLIF_ERROR;
+    if (!PyBytes_Check(glifObj)) {
+        Py_DECREF(glifObj);
+        return GLIF_UNSUPPORTED;
+    }
+
+    parser.pos = PyBytes_AS_STRING(glifObj);
+    parser.end = parser.pos + PyBytes_GET_SIZE(glifObj);
+    result = findOutline(&parser, &outline, &found);
+    /* A missing or empty outline adds nothing, not even a separator. */
+    if (result == GLIF_OK && found && !outline.isEmpty) {
+        GlifParser probe = parser;
+        GlifTag child;
+        if (nextTag(&probe, &child) != GLIF_OK)
+            result = GLIF_UNSUPPORTED;
+        else if (!child.isEnd)
+            result = startItem(writer, items)
+                       ? writeOutline(writer, &parser, useTransform, level + 1)
+                       : GLIF_ERROR;
+    }
+    Py_DECREF(glifObj);
+    return result;
+}
+
+/* Writes the items of an outline element, from just after its start tag. */
+static int
+writeOutline(BezWriter* writer, GlifParser* parser,
+             const GlifTransform* transform, int level)
+{
+    GlifTag tag;
+    int items = 0;
+
+    if (level > MAX_COMPONENT_LEVEL)
+        return GLIF_UNSUPPORTED;
+
+    for (;;) {
+        int result = GLIF_OK;
+        if (nextTag(parser, &tag) != GLIF_OK)
+            return GLIF_UNSUPPORTED;
+        if (tag.isEnd)
+            return isTag(&tag, "outline") ? GLIF_OK : GLIF_UNSUPPORTED;
+
+        if (isTag(&tag, "component")) {
+            if (skipElement(parser, &tag) != GLIF_OK)
+                return GLIF_UNSUPPORTED;
+            result = writeComponent(writer, &items, &tag, transform, level);
+        } else if (isTag(&tag, "contour")) {
+            size_t count;
+            result = readContour(writer, parser, &tag, &count);
+            if (result == GLIF_OK && count > 0)
+                result = writeContour(writer, &items, transform, count);
+        } else if (skipElement(parser, &tag) != GLIF_OK) {
+            return GLIF_UNSUPPORTED;
+        }
+        if (result != GLIF_OK)
+            return result;
+    }
+}
+
+static char glif_to_bez_doc[] =
+  "Convert the outline of a GLIF glyph to bez format.\n"
+  "\n"
+  "Signature:\n"
+  "  glif_to_bez(glif, get_component[, allow_decimals])\n"
+  "\n"
+  "Args:\n"
+  "  glif: GLIF data of the glyph.\n"
+  "  get_component: function returning the GLIF data of a component glyph,\n"
+  "    given its name.\n"
+  "  allow_decimals: do not round coordinates to integers.\n"
+  "\n"
+  "Output:\n"
+  "  The outline in bez format, the same as from\n"
+  "  ufoTools.convertGlyphOutlineToBezString, or None if the glyph has no\n"
+  "  outline or has one that this function does not handle.\n";
+
+static PyObject*
+glif_to_bez(PyObject* self, PyObject* args)
+{
+    int allowDecimals = false;
+    const char* glif = NULL;
+    Py_ssize_t glifLength = 0;
+    PyObject* getComponent = NULL;
+    PyObject* outObj = NULL;
+    BezWriter writer;
+    GlifParser parser;
+    GlifTag outline;
+    bool found;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "s#O|i", &glif, &glifLength, &getComponent,
+                          &allowDecimals))
+        return NULL;
+
+    memset(&writer, 0, sizeof(writer));
+    writer.getComponent = getComponent;
+    writer.allowDecimals = allowDecimals;
+    if (!writeText(&writer, "", 0))
+        return NULL;
+
+    parser.pos = glif;
+    parser.end = glif + glifLength;
+    result = findOutline(&parser, &outline, &found);
+    if (result == GLIF_OK && !found)
+        result = GLIF_UNSUPPORTED;
+    if (result == GLIF_OK && !outline.isEmpty)
+        result = writeOutline(&writer, &parser, NULL, 0);
+
+    if (result == GLIF_OK) {
+#if PY_MAJOR_VERSION >= 3
+        outObj = PyUnicode_FromStringAndSize(writer.data, writer.length);
+#else
+        outObj = PyBytes_FromStringAndSize(writer.data, writer.length);
+#endif
+    } else if (result == GLIF_UNSUPPORTED) {
+        outObj = Py_None;
+        Py_INCREF(outObj);
+    }
+
+    MEMFREE(writer.data);
+    MEMFREE(writer.points);
+    return outObj;
+}
+
+/* bez to Type 2 charstring conversion.
+ *
+ * This follows BezTools.convertBezToT2 and optimizeT2Program, and encodes the
+ * resulting program the way fontTools compiles it, so that the charstring is
+ * the same as the one from the Python code. The hint masks are built as bit
+ * sets rather than lists of hints. Input that AC does not write, including
+ * everything the Python code fails on, makes it return None. */
+
+#define T2_STACK_LIMIT 46
+#define T2_MAX_HINTS ((T2_STACK_LIMIT - 2) / 2)
+#define T2_MAX_MASK_BYTES ((2 * T2_MAX_HINTS + 7) / 8)
+
+/* Results of the conversion functions below. */
+#define T2_OK 1
+#define T2_UNSUPPORTED 0
+#define T2_ERROR -1
+
+/* Type 2 operators, escaped ones have the escape byte in the high byte. */
+enum
+{
+    kT2NoOp = 0,
+    kT2HStem = 1,
+    kT2VStem = 3,
+    kT2VMoveTo = 4,
+    kT2RLineTo = 5,
+    kT2HLineTo = 6,
+    kT2VLineTo = 7,
+    kT2RRCurveTo = 8,
+    kT2CallSubr = 10,
+    kT2Return = 11,
+    kT2EndChar = 14,
+    kT2HStemHM = 18,
+    kT2HintMask = 19,
+    kT2CntrMask = 20,
+    kT2RMoveTo = 21,
+    kT2HMoveTo = 22,
+    kT2VStemHM = 23,
+    kT2RCurveLine = 24,
+    kT2RLineCurve = 25,
+    kT2VVCurveTo = 26,
+    kT2HHCurveTo = 27,
+    kT2CallGSubr = 29,
+    kT2VHCurveTo = 30,
+    kT2HVCurveTo = 31,
+    kT2HFlex = 0x0c22,
+    kT2Flex = 0x0c23,
+    kT2HFlex1 = 0x0c24,
+    kT2Flex1 = 0x0c25
+};
+
+enum
+{
+    kT2Horizontal,
+    kT2Vertical
+};
+
+/* Results of BezTools.checkStem3ArgsOverlap. */
+enum
+{
+    kHintArgsNoOverlap,
+    kHintArgsOverlap,
+    kHintArgsMatch
+};
+
+/* The last bez operator, as far as stem3 hints care. */
+enum
+{
+    kBezOtherOp,
+    kBezVStem3,
+    kBezHStem3
+};
+
+typedef struct
+{
+    void* items;
+    size_t count;
+    size_t capacity;
+} T2Array;
+
+#define T2_ITEMS(array, type) ((type*)(array).items)
+
+typedef struct
+{
+    double pos;
+    double width;
+} T2Hint;
+
+/* A hint of a hint mask, counter mask or group of stem3 hints. */
+typedef struct
+{
+    size_t set;
+    size_t hint;
+    int dir;
+} T2SetHint;
+
+typedef struct
+{
+    int op;
+    size_t arg;
+    int argCount;
+} T2Op;
+
+typedef struct
+{
+    T2Array hints[2];       /* T2Hint, in the order they are seen */
+    T2Array sortedHints[2]; /* T2Hint */
+    T2Array ranks[2];       /* size_t, index of each hint in sortedHints */
+    size_t hintCount[2];    /* hints that fit on the stack */
+    T2Array maskHints;      /* T2SetHint */
+    size_t maskCount;
+    T2Array stem3Hints; /* T2SetHint */
+    size_t stem3Groups[2];
+    bool stem3Open[2];
+    T2Array counterHints; /* T2SetHint */
+    size_t counterCount;
+    T2Array ops;     /* T2Op, hint masks have the mask in arg */
+    T2Array args;    /* double */
+    T2Array current; /* double, operands of the next bez operator */
+} T2Program;
+
+typedef struct
+{
+    T2Array data;
+    int status;
+} T2Writer;
+
+typedef struct
+{
+    T2Writer* writer;
+    double args[T2_STACK_LIMIT + 16];
+    int argCount;
+    int pendingOp;
+    int sequenceOp;
+} T2Optimizer;
+
+typedef struct
+{
+    const char* name;
+    int op;
+    int argCount;
+    bool isAbsolute;
+} BezPathOp;
+
+/* clang-format off */
+static const BezPathOp bezPathOps[] = {
+  { "mt", kT2RMoveTo, 2, true },
+  { "rmt", kT2RMoveTo, 2, false },
+  { "hmt", kT2HMoveTo, 1, false },
+  { "vmt", kT2VMoveTo, 1, false },
+  { "dt", kT2RLineTo, 2, true },
+  { "rdt", kT2RLineTo, 2, false },
+  { "hdt", kT2HLineTo, 1, false },
+  { "vdt", kT2VLineTo, 1, false },
+  { "ct", kT2RRCurveTo, 6, true },
+  { "rct", kT2RRCurveTo, 6, false },
+  { "rcv", kT2RRCurveTo, 6, false },
+  { "vhct", kT2VHCurveTo, 4, false },
+  { "hvct", kT2HVCurveTo, 4, false },
+  { "cp", kT2NoOp, 0, false },
+  { "ed", kT2EndChar, 0, false },
+  { NULL, 0, 0, false }
+};
+/* clang-format on */
+
+static void*
+appendItems(T2Array* array, size_t count, size_t size)
+{
+    void* items;
+    if (array->count + count > array->capacity) {
+        size_t capacity = 2 * array->capacity + count + 16;
+        items = MEMRENEW(array->items, capacity * size);
+        if (!items) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        array->items = items;
+        array->capacity = capacity;
+    }
+    items = (char*)array->items + array->count * size;
+    array->count += count;
+    return items;
+}
+
+static bool
+isBezSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+}
+
+/* Returns the end of the comment starting at pos, or NULL if there is none.
+ * Like the regular expression the Python code drops them with, this needs a
+ * line end and at least one character before it. */
+static const char*
+bezCommentEnd(const char* pos, const char* end)
+{
+    const char* eol;
+    if (*pos != '%' || end - pos < 3)
+        return NULL;
+    eol = memchr(pos + 1, '\n', end - pos - 1);
+    if (!eol || eol == pos + 1)
+        return NULL;
+    return eol + 1;
+}
+
+static bool
+isBezToken(const char* token, size_t length, const char* name)
+{
+    return length == strlen(name) && memcmp(token, name, length) == 0;
+}
+
+/* Parses a number the way round(float(token), 2) does, but only in plain forms
+ * with at most two decimals, for which rounding changes nothing. */
+static bool
+parseBezNumber(const char* token, size_t length, double* value)
+{
+    char text[32];
+    char* endptr;
+    size_t i = 0, digits = 0, decimals = 0;
+    bool point = false;
+
+    if (length >= sizeof(text))
+        return false;
+    if (token[0] == '-' || token[0] == '+')
+        i++;
+    for (; i < length; i++) {
+        if (token[i] >= '0' && token[i] <= '9') {
+            digits++;
+            if (point && ++decimals > 2)
+                return false;
+        } else if (token[i] == '.' && !point) {
+            point = true;
+        } else {
+            return false;
+        }
+    }
+    if (digits == 0)
+        return false;
+    memcpy(text, token, length);
+    text[length] = '\0';
+
+    *value = PyOS_string_to_double(text, &endptr, NULL);
+    if (*value == -1.0 && PyErr_Occurred()) {
+        PyErr_Clear();
+        return false;
+    }
+    return *endptr == '\0';
+}
+
+static int
+addT2Op(T2Program* p, int op, const double* args, int argCount)
+{
+    T2Op* t2Op;
+    double* opArgs;
+
+    t2Op = appendItems(&p->ops, 1, sizeof(T2Op));
+    if (!t2Op)
+        return T2_ERROR;
+    t2Op->op = op;
+    t2Op->arg = p->args.count;
+    t2Op->argCount = argCount;
+    if (argCount > 0) {
+        opArgs = appendItems(&p->args, argCount, sizeof(double));
+        if (!opArgs)
+            return T2_ERROR;
+        memcpy(opArgs, args, argCount * sizeof(double));
+    }
+    return T2_OK;
+}
+
+static int
+addSetHint(T2Array* setHints, size_t set, int dir, size_t hint)
+{
+    T2SetHint* setHint = appendItems(setHints, 1, sizeof(T2SetHint));
+    if (!setHint)
+        return T2_ERROR;
+    setHint->set = set;
+    setHint->hint = hint;
+    setHint->dir = dir;
+    return T2_OK;
+}
+
+/* Adds the hint given by the current operands to the hints and the current
+ * hint mask, and returns its index in *hint. */
+static int
+addHint(T2Program* p, int dir, size_t* hint)
+{
+    T2Hint* hints = T2_ITEMS(p->hints[dir], T2Hint);
+    const double* args = T2_ITEMS(p->current, double);
+    size_t i;
+
+    if (p->current.count != 2)
+        return T2_UNSUPPORTED;
+
+    for (i = 0; i < p->hints[dir].count; i++) {
+        if (hints[i].pos == args[0] && hints[i].width == args[1])
+            break;
+    }
+    if (i == p->hints[dir].count) {
+        T2Hint* newHint = appendItems(&p->hints[dir], 1, sizeof(T2Hint));
+        if (!newHint)
+            return T2_ERROR;
+        newHint->pos = args[0];
+        newHint->width = args[1];
+    }
+    p->current.count = 0;
+    *hint = i;
+    return addSetHint(&p->maskHints, p->maskCount - 1, dir, i);
+}
+
+/* Adds a stem3 hint. Each run of them is one group. */
+static int
+addStem3Hint(T2Program* p, int dir, size_t hint, bool isNewRun)
+{
+    if (isNewRun && p->stem3Open[dir]) {
+        p->stem3Groups[dir]++;
+        p->stem3Open[dir] = false;
+    }
+    p->stem3Open[dir] = true;
+    return addSetHint(&p->stem3Hints, p->stem3Groups[dir], dir, hint);
+}
+
+static void
+makeRelativeCurve(double* args, double* curX, double* curY)
+{
+    double newX = args[4];
+    double newY = args[5];
+    args[5] -= args[3];
+    args[4] -= args[2];
+    args[3] -= args[1];
+    args[2] -= args[0];
+    args[0] -= *curX;
+    args[1] -= *curY;
+    *curX = newX;
+    *curY = newY;
+}
+
+static int
+parseBez(T2Program* p, const char* pos, const char* end)
+{
+    double curX = 0, curY = 0;
+    int lastOp = kBezOtherOp;
+    size_t tokenCount = 0;
+    int result = T2_OK;
+
+    p->maskCount = 1;
+    while (result == T2_OK) {
+        const char *token, *commentEnd;
+        size_t length, hint;
+        double value;
+        double* args;
+        int i;
+
+        while (pos < end && isBezSpace(*pos))
+            pos++;
+        if (pos == end)
+            break;
+        commentEnd = bezCommentEnd(pos, end);
+        if (commentEnd) {
+            pos = commentEnd;
+            continue;
+        }
+        token = pos;
+        while (pos < end && !isBezSpace(*pos)) {
+            /* The Python code would join the token with the one after the
+             * comment. */
+            if (pos > token && bezCommentEnd(pos, end))
+                return T2_UNSUPPORTED;
+            pos++;
+        }
+        length = pos - token;
+        tokenCount++;
+
+        if (parseBezNumber(token, length, &value)) {
+            args = appendItems(&p->current, 1, sizeof(double));
+            if (!args)
+                return T2_ERROR;
+            *args = value;
+            continue;
+        }
+
+        args = T2_ITEMS(p->current, double);
+        if (isBezToken(token, length, "newcolors") ||
+            isBezToken(token, length, "beginsubr") ||
+            isBezToken(token, length, "endsubr") ||
+            isBezToken(token, length, "enc") ||
+            isBezToken(token, length, "sc")) {
+            lastOp = kBezOtherOp;
+        } else if (isBezToken(token, length, "snc")) {
+            lastOp = kBezOtherOp;
+            result = addT2Op(p, kT2HintMask, NULL, 0);
+            if (result == T2_OK)
+                T2_ITEMS(p->ops, T2Op)[p->ops.count - 1].arg = p->maskCount++;
+        } else if (isBezToken(token, length, "div")) {
+            if (p->current.count < 2 || args[p->current.count - 1] == 0)
+                return T2_UNSUPPORTED;
+            args[p->current.count - 2] /= args[p->current.count - 1];
+            p->current.count--;
+        } else if (isBezToken(token, length, "rb")) {
+            lastOp = kBezOtherOp;
+            result = addHint(p, kT2Horizontal, &hint);
+        } else if (isBezToken(token, length, "ry")) {
+            lastOp = kBezOtherOp;
+            result = addHint(p, kT2Vertical, &hint);
+        } else if (isBezToken(token, length, "rm")) {
+            result = addHint(p, kT2Vertical, &hint);
+            if (result == T2_OK)
+                result = addStem3Hint(p, kT2Vertical, hint,
+                                      lastOp != kBezVStem3);
+            lastOp = kBezVStem3;
+        } else if (isBezToken(token, length, "rv")) {
+            result = addHint(p, kT2Horizontal, &hint);
+            if (result == T2_OK)
+                result = addStem3Hint(p, kT2Horizontal, hint,
+                                      lastOp != kBezHStem3);
+            lastOp = kBezHStem3;
+        } else if (isBezToken(token, length, "preflx1")) {
+            /* The preflx1/preflx2 sequence repeats the flex points for
+             * Type 1 output, the moveto of each preflx2 is dropped. */
+            lastOp = kBezOtherOp;
+            p->current.count = 0;
+        } else if (isBezToken(token, length, "preflx2") ||
+                   isBezToken(token, length, "preflx2a")) {
+            T2Op* last;
+            lastOp = kBezOtherOp;
+            if (p->ops.count == 0)
+                return T2_UNSUPPORTED;
+            last = &T2_ITEMS(p->ops, T2Op)[p->ops.count - 1];
+            if (last->op == kT2HintMask)
+                return T2_UNSUPPORTED;
+            p->args.count = last->arg;
+            p->ops.count--;
+            p->current.count = 0;
+        } else if (isBezToken(token, length, "flx") ||
+                   isBezToken(token, length, "flxa")) {
+            double flex[13];
+            lastOp = kBezOtherOp;
+            if (p->current.count < 12)
+                return T2_UNSUPPORTED;
+            memcpy(flex, args, 12 * sizeof(double));
+            if (length == 4) {
+                makeRelativeCurve(flex, &curX, &curY);
+                makeRelativeCurve(flex + 6, &curX, &curY);
+            }
+            flex[12] = 50;
+            result = addT2Op(p, kT2Flex, flex, 13);
+            p->current.count = 0;
+        } else {
+            for (i = 0; bezPathOps[i].name; i++) {
+                if (isBezToken(token, length, bezPathOps[i].name))
+                    break;
+            }
+            if (!bezPathOps[i].name ||
+                p->current.count != (size_t)bezPathOps[i].argCount)
+                return T2_UNSUPPORTED;
+            if (bezPathOps[i].op != kT2NoOp && bezPathOps[i].op != kT2EndChar)
+                lastOp = kBezOtherOp;
+            if (bezPathOps[i].isAbsolute) {
+                if (bezPathOps[i].argCount == 2) {
+                    double x = args[0], y = args[1];
+                    args[0] -= curX;
+                    args[1] -= curY;
+                    curX = x;
+                    curY = y;
+                } else {
+                    makeRelativeCurve(args, &curX, &curY);
+                }
+            }
+            if (bezPathOps[i].op != kT2NoOp)
+                result = addT2Op(p, bezPathOps[i].op, args,
+                                 bezPathOps[i].argCount);
+            p->current.count = 0;
+        }
+    }
+
+    if (result == T2_OK && tokenCount == 0)
+        result = T2_UNSUPPORTED;
+    return result;
+}
+
+static int
+compareHints(const void* a, const void* b)
+{
+    const T2Hint* hint1 = a;
+    const T2Hint* hint2 = b;
+    if (hint1->pos != hint2->pos)
+        return hint1->pos < hint2->pos ? -1 : 1;
+    if (hint1->width != hint2->width)
+        return hint1->width < hint2->width ? -1 : 1;
+    return 0;
+}
+
+static bool
+hasCounterHints(const T2Program* p, int dir, size_t mask)
+{
+    const T2SetHint* counterHints = T2_ITEMS(p->counterHints, T2SetHint);
+    size_t i;
+    for (i = 0; i < p->counterHints.count; i++) {
+        if (counterHints[i].set == mask && counterHints[i].dir == dir)
+            return true;
+    }
+    return false;
+}
+
+/* Compares a group of stem3 hints with the hints of a counter mask, the same
+ * as BezTools.checkStem3ArgsOverlap. */
+static int
+checkStem3Overlap(const T2Program* p, int dir, size_t group, size_t mask)
+{
+    const T2SetHint* stem3Hints = T2_ITEMS(p->stem3Hints, T2SetHint);
+    const T2SetHint* counterHints = T2_ITEMS(p->counterHints, T2SetHint);
+    const T2Hint* hints = T2_ITEMS(p->hints[dir], T2Hint);
+    int status = kHintArgsNoOverlap;
+    size_t i, j;
+
+    for (i = 0; i < p->stem3Hints.count; i++) {
+        double x0, x1;
+        if (stem3Hints[i].set != group || stem3Hints[i].dir != dir)
+            continue;
+        x0 = hints[stem3Hints[i].hint].pos;
+        x1 = x0 + hints[stem3Hints[i].hint].width;
+        for (j = 0; j < p->counterHints.count; j++) {
+            double y0, y1;
+            if (counterHints[j].set != mask || counterHints[j].dir != dir)
+                continue;
+            y0 = hints[counterHints[j].hint].pos;
+            y1 = y0 + hints[counterHints[j].hint].width;
+            if (x0 == y0) {
+                if (x1 == y1)
+                    status = kHintArgsMatch;
+                else
+                    return kHintArgsOverlap;
+            } else if (x1 == y1) {
+                return kHintArgsOverlap;
+            } else if ((x0 > y0 && x0 < y1) || (x1 > y0 && x1 < y1)) {
+                return kHintArgsOverlap;
+            }
+        }
+    }
+    return status;
+}
+
+static int
+addCounterGroup(T2Program* p, int dir, size_t group, size_t mask)
+{
+    size_t i;
+    for (i = 0; i < p->stem3Hints.count; i++) {
+        const T2SetHint* stem3Hint = &T2_ITEMS(p->stem3Hints, T2SetHint)[i];
+        if (stem3Hint->set == group && stem3Hint->dir == dir &&
+            addSetHint(&p->counterHints, mask, dir, stem3Hint->hint) != T2_OK)
+            return T2_ERROR;
+    }
+    return T2_OK;
+}
+
+/* Puts each group of stem3 hints in the first counter mask that has no hints
+ * in its direction or has matching ones, or in a new mask, like
+ * BezTools.buildControlMaskList. */
+static int
+buildCounterMasks(T2Program* p)
+{
+    int dir;
+
+    if (p->stem3Hints.count == 0)
+        return T2_OK;
+    p->counterCount = 1;
+    for (dir = kT2Horizontal; dir <= kT2Vertical; dir++) {
+        size_t groupCount = p->stem3Groups[dir] + p->stem3Open[dir];
+        size_t group, mask;
+        for (group = 0; group < groupCount; group++) {
+            int status = kHintArgsNoOverlap;
+            for (mask = 0; mask < p->counterCount; mask++) {
+                if (!hasCounterHints(p, dir, mask)) {
+                    if (addCounterGroup(p, dir, group, mask) != T2_OK)
+                        return T2_ERROR;
+                    status = kHintArgsMatch;
+                    break;
+                }
+                status = checkStem3Overlap(p, dir, group, mask);
+                if (status == kHintArgsMatch)
+                    break;
+            }
+            if (status != kHintArgsMatch &&
+                addCounterGroup(p, dir, group, p->counterCount++) != T2_OK)
+                return T2_ERROR;
+        }
+    }
+    return T2_OK;
+}
+
+/* Sorts the hints and drops those that do not fit on the stack. */
+static int
+sortHints(T2Program* p)
+{
+    int dir;
+    for (dir = kT2Horizontal; dir <= kT2Vertical; dir++) {
+        size_t count = p->hints[dir].count;
+        const T2Hint* hints = T2_ITEMS(p->hints[dir], T2Hint);
+        T2Hint* sorted;
+        size_t* ranks;
+        size_t i;
+
+        if (count == 0)
+            continue;
+        sorted = appendItems(&p->sortedHints[dir], count, sizeof(T2Hint));
+        ranks = appendItems(&p->ranks[dir], count, sizeof(size_t));
+        if (!sorted || !ranks)
+            return T2_ERROR;
+        memcpy(sorted, hints, count * sizeof(T2Hint));
+        qsort(sorted, count, sizeof(T2Hint), compareHints);
+        for (i = 0; i < count; i++) {
+            const T2Hint* hint = bsearch(&hints[i], sorted, count,
+                                         sizeof(T2Hint), compareHints);
+            ranks[i] = hint - sorted;
+        }
+        p->hintCount[dir] = count < T2_MAX_HINTS ? count : T2_MAX_HINTS;
+    }
+    return T2_OK;
+}
+
+static void
+writeT2Bytes(T2Writer* writer, const unsigned char* bytes, size_t length)
+{
+    unsigned char* data;
+    if (writer->status != T2_OK)
+        return;
+    data = appendItems(&writer->data, length, 1);
+    if (!data) {
+        writer->status = T2_ERROR;
+        return;
+    }
+    memcpy(data, bytes, length);
+}
+
+/* Encodes a number like fontTools does: as a 16.16 fixed value rounded up
+ * from halves, or as an integer if it has no fraction. */
+static void
+writeT2Number(T2Writer* writer, double value)
+{
+    unsigned char bytes[5];
+    size_t length;
+    double fixed = floor(value * 65536 + 0.5);
+
+    if (!(fixed >= -2147483648.0 && fixed <= 2147483647.0)) {
+        writer->status = T2_UNSUPPORTED;
+        return;
+    }
+    if (fmod(fixed, 65536) == 0) {
+        long v = (long)(fixed / 65536);
+        if (v >= -107 && v <= 107) {
+            bytes[0] = (unsigned char)(v + 139);
+            length = 1;
+        } else if (v >= 108 && v <= 1131) {
+            v -= 108;
+            bytes[0] = (unsigned char)((v >> 8) + 247);
+            bytes[1] = (unsigned char)(v & 0xff);
+            length = 2;
+        } else if (v >= -1131 && v <= -108) {
+            v = -v - 108;
+            bytes[0] = (unsigned char)((v >> 8) + 251);
+            bytes[1] = (unsigned char)(v & 0xff);
+            length = 2;
+        } else {
+            unsigned long u = (unsigned long)v;
+            bytes[0] = 28;
+            bytes[1] = (unsigned char)((u >> 8) & 0xff);
+            bytes[2] = (unsigned char)(u & 0xff);
+            length = 3;
+        }
+    } else {
+        unsigned long u = (unsigned long)(long)fixed;
+        bytes[0] = 255;
+        bytes[1] = (unsigned char)((u >> 24) & 0xff);
+        bytes[2] = (unsigned char)((u >> 16) & 0xff);
+        bytes[3] = (unsigned char)((u >> 8) & 0xff);
+        bytes[4] = (unsigned char)(u & 0xff);
+        length = 5;
+    }
+    writeT2Bytes(writer, bytes, length);
+}
+
+static void
+writeT2Op(T2Writer* writer, int op, const double* args, int argCount)
+{
+    unsigned char bytes[2];
+    int i;
+
+    for (i = 0; i < argCount; i++)
+        writeT2Number(writer, args[i]);
+    if (op == kT2NoOp)
+        return;
+    if (op > 0xff) {
+        bytes[0] = (unsigned char)(op >> 8);
+        bytes[1] = (unsigned char)(op & 0xff);
+        writeT2Bytes(writer, bytes, 2);
+    } else {
+        bytes[0] = (unsigned char)op;
+        writeT2Bytes(writer, bytes, 1);
+    }
+}
+
+static void
+writeT2Hints(T2Writer* writer, const T2Program* p, int dir, int op)
+{
+    const T2Hint* hints = T2_ITEMS(p->sortedHints[dir], T2Hint);
+    double args[2 * T2_MAX_HINTS];
+    double lastPos = 0;
+    size_t i;
+
+    for (i = 0; i < p->hintCount[dir]; i++) {
+        args[2 * i] = hints[i].pos - lastPos;
+        args[2 * i + 1] = hints[i].width;
+        lastPos = hints[i].pos + hints[i].width;
+    }
+    writeT2Op(writer, op, args, (int)(2 * p->hintCount[dir]));
+}
+
+static void
+writeT2Mask(T2Writer* writer, const T2Program* p, int op,
+            const T2Array* setHints, size_t set)
+{
+    const T2SetHint* hints = T2_ITEMS(*setHints, T2SetHint);
+    unsigned char bytes[1 + T2_MAX_MASK_BYTES];
+    size_t length = (7 + p->hintCount[0] + p->hintCount[1]) / 8;
+    size_t i;
+
+    memset(bytes, 0, sizeof(bytes));
+    bytes[0] = (unsigned char)op;
+    for (i = 0; i < setHints->count; i++) {
+        size_t bit;
+        if (hints[i].set != set)
+            continue;
+        bit = T2_ITEMS(p->ranks[hints[i].dir], size_t)[hints[i].hint];
+        if (bit >= p->hintCount[hints[i].dir])
+            continue; /* dropped for the stack limit */
+        if (hints[i].dir == kT2Vertical)
+            bit += p->hintCount[kT2Horizontal];
+        bytes[1 + bit / 8] |= 0x80 >> (bit % 8);
+    }
+    writeT2Bytes(writer, bytes, 1 + length);
+}
+
+/* The operator merging of optimizeT2Program. The pending operator collects
+ * the operands of operators that can be merged into it, and the sequence
+ * operator is the last one merged, for the alternating ones. */
+
+static void
+setOptimizerArgs(T2Optimizer* o, const double* args, int argCount)
+{
+    memcpy(o->args, args, argCount * sizeof(double));
+    o->argCount = argCount;
+}
+
+static void
+addOptimizerArgs(T2Optimizer* o, const double* args, int argCount)
+{
+    memcpy(o->args + o->argCount, args, argCount * sizeof(double));
+    o->argCount += argCount;
+}
+
+/* Writes the pending operator with its first argCount operands. */
+static void
+writePending(T2Optimizer* o, int argCount)
+{
+    writeT2Op(o->writer, o->pendingOp, o->args, argCount);
+}
+
+static void
+endPending(T2Optimizer* o)
+{
+    if (o->pendingOp != kT2NoOp)
+        writePending(o, o->argCount);
+    o->argCount = 0;
+    o->pendingOp = o->sequenceOp = kT2NoOp;
+}
+
+static void
+startPending(T2Optimizer* o, int op, const double* args, int argCount)
+{
+    endPending(o);
+    setOptimizerArgs(o, args, argCount);
+    o->pendingOp = o->sequenceOp = op;
+}
+
+/* Starts a new operator when the stack is full, with the operands just
+ * added. */
+static bool
+splitPending(T2Optimizer* o, const double* args, int argCount)
+{
+    if (o->argCount < T2_STACK_LIMIT)
+        return false;
+    writePending(o, o->argCount - argCount);
+    setOptimizerArgs(o, args, argCount);
+    return true;
+}
+
+static void
+addLine(T2Optimizer* o, int op, double d)
+{
+    int other = op == kT2VLineTo ? kT2HLineTo : kT2VLineTo;
+    if ((o->pendingOp == kT2VLineTo || o->pendingOp == kT2HLineTo) &&
+        o->sequenceOp == other) {
+        addOptimizerArgs(o, &d, 1);
+        o->sequenceOp = op;
+        if (splitPending(o, &d, 1))
+            o->pendingOp = op;
+    } else {
+        startPending(o, op, &d, 1);
+    }
+}
+
+static void
+addAlternatingCurve(T2Optimizer* o, int op, const double* args, int argCount)
+{
+    int other = op == kT2VHCurveTo ? kT2HVCurveTo : kT2VHCurveTo;
+    if ((o->pendingOp == kT2VHCurveTo || o->pendingOp == kT2HVCurveTo) &&
+        o->sequenceOp == other) {
+        addOptimizerArgs(o, args, argCount);
+        o->sequenceOp = op;
+        if (splitPending(o, args, argCount))
+            o->pendingOp = op;
+    } else {
+        startPending(o, op, args, argCount);
+    }
+    /* An odd number of operands ends the curves. */
+    if (argCount == 5)
+        endPending(o);
+}
+
+static void
+addSameCurve(T2Optimizer* o, int op, const double* args)
+{
+    if (o->pendingOp != op && o->pendingOp != kT2NoOp)
+        endPending(o);
+    addOptimizerArgs(o, args, 4);
+    splitPending(o, args, 4);
+    o->pendingOp = o->sequenceOp = op;
+}
+
+static void
+addSingleOp(T2Optimizer* o, int op, const double* args, int argCount)
+{
+    endPending(o);
+    writeT2Op(o->writer, op, args, argCount);
+}
+
+static void
+addCurve(T2Optimizer* o, const double* a)
+{
+    double dx1 = a[0], dy1 = a[1], dx2 = a[2], dy2 = a[3], dx3 = a[4],
+           dy3 = a[5];
+
+    if (dx1 == 0) {
+        if (dy3 == 0) {
+            double args[4] = { dy1, dx2, dy2, dx3 };
+            addAlternatingCurve(o, kT2VHCurveTo, args, 4);
+        } else if (dx3 == 0) {
+            double args[4] = { dy1, dx2, dy2, dy3 };
+            addSameCurve(o, kT2VVCurveTo, args);
+        } else {
+            double args[5] = { dy1, dx2, dy2, dx3, dy3 };
+            addAlternatingCurve(o, kT2VHCurveTo, args, 5);
+        }
+    } else if (dy1 == 0) {
+        if (dx3 == 0) {
+            double args[4] = { dx1, dx2, dy2, dy3 };
+            addAlternatingCurve(o, kT2HVCurveTo, args, 4);
+        } else if (dy3 == 0) {
+            double args[4] = { dx1, dx2, dy2, dx3 };
+            addSameCurve(o, kT2HHCurveTo, args);
+        } else {
+            double args[5] = { dx1, dx2, dy2, dy3, dx3 };
+            addAlternatingCurve(o, kT2HVCurveTo, args, 5);
+        }
+    } else if (dx3 == 0) {
+        double args[5] = { dx1, dy1, dx2, dy2, dy3 };
+        addSingleOp(o, kT2VVCurveTo, args, 5);
+    } else if (dy3 == 0) {
+        double args[5] = { dy1, dx1, dx2, dy2, dx3 };
+        addSingleOp(o, kT2HHCurveTo, args, 5);
+    } else if (o->pendingOp == kT2RLineTo) {
+        addOptimizerArgs(o, a, 6);
+        if (splitPending(o, a, 6)) {
+            o->pendingOp = o->sequenceOp = kT2RRCurveTo;
+        } else {
+            o->pendingOp = kT2RLineCurve;
+            endPending(o);
+        }
+    } else {
+        if (o->pendingOp != kT2RRCurveTo)
+            endPending(o);
+        addOptimizerArgs(o, a, 6);
+        splitPending(o, a, 6);
+        o->pendingOp = o->sequenceOp = kT2RRCurveTo;
+    }
+}
+
+static void
+addFlex(T2Optimizer* o, const double* a)
+{
+    endPending(o);
+    if (a[5] == 0 && a[7] == 0) {
+        if (a[1] == 0 && a[11] == 0 && a[3] == -a[9]) {
+            double args[7] = { a[0], a[2], a[3], a[4], a[6], a[8], a[10] };
+            writeT2Op(o->writer, kT2HFlex, args, 7);
+            return;
+        }
+        if (a[1] + a[3] + a[5] + a[7] + a[9] + a[11] == 0) {
+            double args[9] = { a[0], a[1], a[2], a[3], a[4],
+                               a[6], a[8], a[9], a[10] };
+            writeT2Op(o->writer, kT2HFlex1, args, 9);
+            return;
+        }
+    }
+    writeT2Op(o->writer, kT2Flex, a, 13);
+}
+
+static void
+addOptimizedOp(T2Optimizer* o, int op, const double* args, int argCount)
+{
+    switch (op) {
+        case kT2VLineTo:
+        case kT2HLineTo:
+            addLine(o, op, args[argCount - 1]);
+            break;
+        case kT2RLineTo:
+            if (args[0] == 0) {
+                addLine(o, kT2VLineTo, args[1]);
+            } else if (args[1] == 0) {
+                addLine(o, kT2HLineTo, args[0]);
+            } else if (o->pendingOp == kT2RRCurveTo) {
+                addOptimizerArgs(o, args, 2);
+                if (splitPending(o, args, 2)) {
+                    o->pendingOp = o->sequenceOp = kT2RLineTo;
+                } else {
+                    o->pendingOp = kT2RCurveLine;
+                    endPending(o);
+                }
+            } else if (o->pendingOp == kT2RLineTo &&
+                       o->sequenceOp == kT2RLineTo) {
+                addOptimizerArgs(o, args, 2);
+                splitPending(o, args, 2);
+            } else {
+                startPending(o, op, args, 2);
+            }
+            break;
+        case kT2VHCurveTo:
+        case kT2HVCurveTo:
+            addAlternatingCurve(o, op, args, argCount);
+            break;
+        case kT2RRCurveTo:
+            addCurve(o, args);
+            break;
+        case kT2Flex:
+            addFlex(o, args);
+            break;
+        default:
+            addSingleOp(o, op, args, argCount);
+            break;
+    }
+}
+
+static void
+writeT2Program(T2Writer* writer, const T2Program* p)
+{
+    const T2Op* ops = T2_ITEMS(p->ops, T2Op);
+    const double* args = T2_ITEMS(p->args, double);
+    bool needHintMasks = p->maskCount > 1;
+    T2Optimizer optimizer;
+    size_t i;
+
+    if (p->hintCount[kT2Horizontal] > 0)
+        writeT2Hints(writer, p, kT2Horizontal,
+                     needHintMasks ? kT2HStemHM : kT2HStem);
+    /* With hint masks, vstemhm is implied by the first mask. */
+    if (p->hintCount[kT2Vertical] > 0)
+        writeT2Hints(writer, p, kT2Vertical,
+                     needHintMasks ? kT2NoOp : kT2VStem);
+
+    for (i = 0; i < p->counterCount; i++)
+        writeT2Mask(writer, p, kT2CntrMask, &p->counterHints, i);
+
+    /* If there is no hint substitution before the first operator, the
+     * initial hints need a mask too. */
+    if (needHintMasks && ops[0].op != kT2HintMask)
+        writeT2Mask(writer, p, kT2HintMask, &p->maskHints, 0);
+
+    memset(&optimizer, 0, sizeof(optimizer));
+    optimizer.writer = writer;
+    for (i = 0; i < p->ops.count; i++) {
+        if (ops[i].op == kT2HintMask) {
+            endPending(&optimizer);
+            writeT2Mask(writer, p, kT2HintMask, &p->maskHints, ops[i].arg);
+        } else {
+            addOptimizedOp(&optimizer, ops[i].op, args + ops[i].arg,
+                           ops[i].argCount);
+        }
+    }
+    endPending(&optimizer);
+}
+
+static void
+freeT2Program(T2Program* p)
+{
+    int dir;
+    for (dir = kT2Horizontal; dir <= kT2Vertical; dir++) {
+        MEMFREE(p->hints[dir].items);
+        MEMFREE(p->sortedHints[dir].items);
+        MEMFREE(p->ranks[dir].items);
+    }
+    MEMFREE(p->maskHints.items);
+    MEMFREE(p->stem3Hints.items);
+    MEMFREE(p->counterHints.items);
+    MEMFREE(p->ops.items);
+    MEMFREE(p->args.items);
+    MEMFREE(p->current.items);
+}
+
+static char bez_to_t2_doc[] =
+  "Convert a glyph in bez format to a Type 2 charstring.\n"
+  "\n"
+  "Signature:\n"
+  "  bez_to_t2(bez[, width])\n"
+  "\n"
+  "Args:\n"
+  "  bez: bez data of the glyph.\n"
+  "  width: width operand of the charstring, or None to leave it out.\n"
+  "\n"
+  "Output:\n"
+  "  The compiled charstring, the same as from BezTools.convertBezToT2 with\n"
+  "  the width in front, or None if the glyph has operators or operands that\n"
+  "  this function does not handle.\n";
+
+static PyObject*
+bez_to_t2(PyObject* self, PyObject* args)
+{
+    const char* bez = NULL;
+    Py_ssize_t bezLength = 0;
+    PyObject* widthObj = Py_None;
+    PyObject* outObj = NULL;
+    T2Program program;
+    T2Writer writer;
+    int result;
+
+    if (!PyArg_ParseTuple(args, "s#|O", &bez, &bezLength, &widthObj))
+        return NULL;
+
+    memset(&program, 0, sizeof(program));
+    memset(&writer, 0, sizeof(writer));
+    writer.status = T2_OK;
+    if (widthObj != Py_None) {
+        double width = PyFloat_AsDouble(widthObj);
+        if (width == -1.0 && PyErr_Occurred())
+            return NULL;
+        writeT2Number(&writer, width);
+    }
+
+    result = parseBez(&program, bez, bez + bezLength);
+    if (result == T2_OK)
+        result = sortHints(&program);
+    if (result == T2_OK)
+        result = buildCounterMasks(&program);
+    if (result == T2_OK) {
+        writeT2Program(&writer, &program);
+        result = writer.status;
+    }
+
+    if (result == T2_OK) {
+        outObj =
+          PyBytes_FromStringAndSize(writer.data.items, writer.data.count);
+    } else if (result == T2_UNSUPPORTED) {
+        outObj = Py_None;
+        Py_INCREF(outObj);
+    }
+
+    freeT2Program(&program);
+    MEMFREE(writer.data.items);
+    return outObj;
+}
+
+/* Type 2 charstring to bez conversion.
+ *
+ * This follows BezTools.T2ToBezExtractor with the hints removed, which is how
+ * autohint reads CFF glyphs, running the charstring and its subroutines
+ * straight from their bytes. Fixed point operands, arithmetic operators, seac
+ * and charstrings that the Python code rejects or reads in its own way make it
+ * return None. All other operands are integers, so the points are exact. */
+
+#define T2_MAX_STACK 513
+#define T2_MAX_SUBR_DEPTH 10
+#define T2_MAX_COORD 100000000L
+
+typedef struct
+{
+    PyObject* subrs; /* a list or tuple of bytes */
+    Py_ssize_t count;
+    Py_ssize_t bias;
+} T2Subrs;
+
+typedef struct
+{
+    T2Subrs localSubrs;
+    T2Subrs globalSubrs;
+    long stack[T2_MAX_STACK];
+    int stackCount;
+    int depth;
+    long hintCount;
+    long hintMaskBytes;
+    bool gotWidth;
+    bool hasWidth;
+    long width;
+    long x, y;
+    bool sawMoveTo;
+    bool firstMarkingOpSeen;
+    bool closePathWritten; /* the last thing written is a closepath */
+    bool allowDecimals;
+    BezWriter writer;
+} T2Extractor;
+
+static bool
+initT2Subrs(T2Subrs* subrs, PyObject* obj)
+{
+    subrs->subrs = PySequence_Fast(obj, "subroutines must be a sequence");
+    if (!subrs->subrs)
+        return false;
+    subrs->count = PySequence_Fast_GET_SIZE(subrs->subrs);
+    /* Same as fontTools.misc.psCharStrings.calcSubrBias. */
+    if (subrs->count < 1240)
+        subrs->bias = 107;
+    else if (subrs->count < 33900)
+        subrs->bias = 1131;
+    else
+        subrs->bias = 32768;
+    return true;
+}
+
+/* Takes the width from the operands the way T2WidthExtractor.popallWidth
+ * does. A moveto without operands has no width to take, and fails the
+ * operand count check after this. */
+static void
+popWidth(T2Extractor* e, int evenOdd)
+{
+    if (e->gotWidth)
+        return;
+    if (e->stackCount > 0 && (evenOdd ^ (e->stackCount % 2))) {
+        e->hasWidth = true;
+        e->width = e->stack[0];
+        memmove(e->stack, e->stack + 1, (e->stackCount - 1) * sizeof(long));
+        e->stackCount--;
+    }
+    e->gotWidth = true;
+}
+
+static int
+countT2Hints(T2Extractor* e)
+{
+    popWidth(e, 0);
+    if (e->stackCount % 2)
+        return T2_UNSUPPORTED;
+    e->hintCount += e->stackCount / 2;
+    e->stackCount = 0;
+    return T2_OK;
+}
+
+static bool
+writeBezPoint(T2Extractor* e, long x, long y)
+{
+    char text[64];
+    if (e->allowDecimals)
+        sprintf(text, "%ld.00 %ld.00 ", x, y);
+    else
+        sprintf(text, "%ld %ld ", x, y);
+    return writeText(&e->writer, text, strlen(text));
+}
+
+static bool
+writeBezOp(T2Extractor* e, const char* op)
+{
+    e->closePathWritten = false;
+    return writeText(&e->writer, op, strlen(op));
+}
+
+/* Moves the current point, returns false if it gets unreasonably far. */
+static bool
+nextT2Point(T2Extractor* e, long dx, long dy)
+{
+    e->x += dx;
+    e->y += dy;
+    return e->x > -T2_MAX_COORD && e->x < T2_MAX_COORD &&
+           e->y > -T2_MAX_COORD && e->y < T2_MAX_COORD;
+}
+
+/* Writes a moveto to the current point. The Python code puts two spaces
+ * between its coordinates. */
+static int
+writeT2MoveTo(T2Extractor* e)
+{
+    char text[64];
+    if (!e->firstMarkingOpSeen) {
+        e->firstMarkingOpSeen = true;
+        if (!writeBezOp(e, "sc\n"))
+            return T2_ERROR;
+    }
+    if (e->allowDecimals)
+        sprintf(text, "%ld.00  %ld.00 mt\n", e->x, e->y);
+    else
+        sprintf(text, "%ld  %ld mt\n", e->x, e->y);
+    e->sawMoveTo = true;
+    return writeBezOp(e, text) ? T2_OK : T2_ERROR;
+}
+
+static int
+t2MoveTo(T2Extractor* e, long dx, long dy)
+{
+    if (!nextT2Point(e, dx, dy))
+        return T2_UNSUPPORTED;
+    return writeT2MoveTo(e);
+}
+
+/* Starts the path before a lineto or curveto, at the end point of it. */
+static int
+startT2Path(T2Extractor* e)
+{
+    if (!e->firstMarkingOpSeen) {
+        e->firstMarkingOpSeen = true;
+        if (!writeBezOp(e, "sc\n") || !writeBezOp(e, "0 0 mt\n"))
+            return T2_ERROR;
+    }
+    if (!e->sawMoveTo)
+        return writeT2MoveTo(e);
+    return T2_OK;
+}
+
+static int
+t2LineTo(T2Extractor* e, long dx, long dy)
+{
+    char text[64];
+    int result;
+
+    if (!nextT2Point(e, dx, dy))
+        return T2_UNSUPPORTED;
+    result = startT2Path(e);
+    if (result != T2_OK)
+        return result;
+    if (e->allowDecimals)
+        sprintf(text, "%ld.00  %ld.00 dt\n", e->x, e->y);
+    else
+        sprintf(text, "%ld  %ld dt\n", e->x, e->y);
+    return writeBezOp(e, text) ? T2_OK : T2_ERROR;
+}
+
+static int
+t2CurveTo(T2Extractor* e, long dx1, long dy1, long dx2, long dy2, long dx3,
+          long dy3)
+{
+    long x1, y1, x2, y2;
+    int result;
+
+    if (!nextT2Point(e, dx1, dy1))
+        return T2_UNSUPPORTED;
+    x1 = e->x;
+    y1 = e->y;
+    if (!nextT2Point(e, dx2, dy2))
+        return T2_UNSUPPORTED;
+    x2 = e->x;
+    y2 = e->y;
+    if (!nextT2Point(e, dx3, dy3))
+        return T2_UNSUPPORTED;
+    result = startT2Path(e);
+    if (result != T2_OK)
+        return result;
+    if (!writeBezPoint(e, x1, y1) || !writeBezPoint(e, x2, y2) ||
+        !writeBezPoint(e, e->x, e->y) || !writeBezOp(e, "ct\n"))
+        return T2_ERROR;
+    return T2_OK;
+}
+
+static int
+endT2Path(T2Extractor* e)
+{
+    if (e->sawMoveTo) {
+        if (!writeBezOp(e, "cp\n"))
+            return T2_ERROR;
+        e->closePathWritten = true;
+    }
+    e->sawMoveTo = false;
+    return T2_OK;
+}
+
+static int executeT2(T2Extractor* e, const unsigned char* code,
+                     Py_ssize_t length);
+
+static int
+callT2Subr(T2Extractor* e, const T2Subrs* subrs)
+{
+    Py_ssize_t index;
+    char* code;
+    Py_ssize_t length;
+
+    if (e->stackCount == 0)
+        return T2_UNSUPPORTED;
+    index = e->stack[--e->stackCount] + subrs->bias;
+    if (index < 0 || index >= subrs->count)
+        return T2_UNSUPPORTED;
+    if (PyBytes_AsStringAndSize(PySequence_Fast_GET_ITEM(subrs->subrs, index),
+                                &code, &length) < 0)
+        return T2_ERROR;
+    return executeT2(e, (const unsigned char*)code, length);
+}
+
+static int
+doT2Op(T2Extractor* e, int op, const unsigned char* code, Py_ssize_t length,
+       Py_ssize_t* pos)
+{
+    const long* s = e->stack;
+    int n = e->stackCount;
+    int result = T2_OK;
+    int i;
+
+    switch (op) {
+        case kT2HStem:
+        case kT2VStem:
+        case kT2HStemHM:
+        case kT2VStemHM:
+            return countT2Hints(e);
+        case kT2HintMask:
+        case kT2CntrMask:
+            /* The first mask can have the vstemhm operands. */
+            if (!e->hintMaskBytes) {
+                if (countT2Hints(e) != T2_OK)
+                    return T2_UNSUPPORTED;
+                e->hintMaskBytes = (e->hintCount + 7) / 8;
+            }
+            if (e->hintMaskBytes > length - *pos)
+                return T2_UNSUPPORTED;
+            *pos += e->hintMaskBytes;
+            return T2_OK;
+        case kT2RMoveTo:
+        case kT2HMoveTo:
+        case kT2VMoveTo:
+            result = endT2Path(e);
+            if (result != T2_OK)
+                return result;
+            popWidth(e, op != kT2RMoveTo);
+            n = e->stackCount;
+            if (n < (op == kT2RMoveTo ? 2 : 1))
+                return T2_UNSUPPORTED;
+            if (op == kT2RMoveTo)
+                result = t2MoveTo(e, s[0], s[1]);
+            else if (op == kT2HMoveTo)
+                result = t2MoveTo(e, s[0], 0);
+            else
+                result = t2MoveTo(e, 0, s[0]);
+            break;
+        case kT2RLineTo:
+            if (n % 2)
+                return T2_UNSUPPORTED;
+            for (i = 0; i < n && result == T2_OK; i += 2)
+                result = t2LineTo(e, s[i], s[i + 1]);
+            break;
+        case kT2HLineTo:
+        case kT2VLineTo:
+            for (i = 0; i < n && result == T2_OK; i++) {
+                if ((i % 2 == 0) == (op == kT2HLineTo))
+                    result = t2LineTo(e, s[i], 0);
+                else
+                    result = t2LineTo(e, 0, s[i]);
+            }
+            break;
+        case kT2RRCurveTo:
+            if (n % 6)
+                return T2_UNSUPPORTED;
+            for (i = 0; i < n && result == T2_OK; i += 6)
+                result = t2CurveTo(e, s[i], s[i + 1], s[i + 2], s[i + 3],
+                                   s[i + 4], s[i + 5]);
+            break;
+        case kT2RCurveLine:
+            if (n < 2 || (n - 2) % 6)
+                return T2_UNSUPPORTED;
+            for (i = 0; i < n - 2 && result == T2_OK; i += 6)
+                result = t2CurveTo(e, s[i], s[i + 1], s[i + 2], s[i + 3],
+                                   s[i + 4], s[i + 5]);
+            if (result == T2_OK)
+                result = t2LineTo(e, s[n - 2], s[n - 1]);
+            break;
+        case kT2RLineCurve:
+            if (n < 6 || (n - 6) % 2)
+                return T2_UNSUPPORTED;
+            for (i = 0; i < n - 6 && result == T2_OK; i += 2)
+                result = t2LineTo(e, s[i], s[i + 1]);
+            if (result == T2_OK)
+                result = t2CurveTo(e, s[n - 6], s[n - 5], s[n - 4], s[n - 3],
+                                   s[n - 2], s[n - 1]);
+            break;
+        case kT2VVCurveTo:
+        case kT2HHCurveTo: {
+            long d1 = 0;
+            i = 0;
+            if (n % 2)
+                d1 = s[i++];
+            if ((n - i) % 4)
+                return T2_UNSUPPORTED;
+            for (; i < n && result == T2_OK; i += 4) {
+                if (op == kT2VVCurveTo)
+                    result = t2CurveTo(e, d1, s[i], s[i + 1], s[i + 2], 0,
+                                       s[i + 3]);
+                else
+                    result = t2CurveTo(e, s[i], d1, s[i + 1], s[i + 2],
+                                       s[i + 3], 0);
+                d1 = 0;
+            }
+            break;
+        }
+        case kT2VHCurveTo:
+        case kT2HVCurveTo: {
+            bool vertical = op == kT2VHCurveTo;
+            if (n % 4 > 1 || n == 1)
+                return T2_UNSUPPORTED;
+            for (i = 0; i < n && result == T2_OK; vertical = !vertical) {
+                const long* a = s + i;
+                long last = 0;
+                i += 4;
+                if (n - i == 1)
+                    last = s[i++];
+                if (vertical)
+                    result = t2CurveTo(e, 0, a[0], a[1], a[2], a[3], last);
+                else
+                    result = t2CurveTo(e, a[0], 0, a[1], a[2], last, a[3]);
+            }
+            break;
+        }
+        case kT2HFlex:
+            if (n != 7)
+                return T2_UNSUPPORTED;
+            result = t2CurveTo(e, s[0], 0, s[1], s[2], s[3], 0);
+            if (result == T2_OK)
+                result = t2CurveTo(e, s[4], 0, s[5], -s[2], s[6], 0);
+            break;
+        case kT2Flex:
+            if (n != 13)
+                return T2_UNSUPPORTED;
+            result = t2CurveTo(e, s[0], s[1], s[2], s[3], s[4], s[5]);
+            if (result == T2_OK)
+                result = t2CurveTo(e, s[6], s[7], s[8], s[9], s[10], s[11]);
+            break;
+        case kT2HFlex1:
+            if (n != 9)
+                return T2_UNSUPPORTED;
+            result = t2CurveTo(e, s[0], s[1], s[2], s[3], s[4], 0);
+            if (result == T2_OK)
+                result = t2CurveTo(e, s[5], 0, s[6], s[7], s[8],
+                                   -(s[1] + s[3] + s[7]));
+            break;
+        case kT2Flex1: {
+            long dx, dy;
+            if (n != 11)
+                return T2_UNSUPPORTED;
+            dx = s[0] + s[2] + s[4] + s[6] + s[8];
+            dy = s[1] + s[3] + s[5] + s[7] + s[9];
+            result = t2CurveTo(e, s[0], s[1], s[2], s[3], s[4], s[5]);
+            if (result == T2_OK) {
+                if (labs(dx) > labs(dy))
+                    result = t2CurveTo(e, s[6], s[7], s[8], s[9], s[10], -dy);
+                else
+                    result = t2CurveTo(e, s[6], s[7], s[8], s[9], -dx, s[10]);
+            }
+            break;
+        }
+        case kT2EndChar:
+            result = endT2Path(e);
+            popWidth(e, 0);
+            /* With operands, this is a seac composite. */
+            if (e->stackCount > 0)
+                return T2_UNSUPPORTED;
+            return result;
+        case kT2Return:
+            /* The operands are left for the caller. */
+            return T2_OK;
+        case kT2CallSubr:
+            return callT2Subr(e, &e->localSubrs);
+        case kT2CallGSubr:
+            return callT2Subr(e, &e->globalSubrs);
+        default:
+            return T2_UNSUPPORTED;
+    }
+    e->stackCount = 0;
+    return result;
+}
+
+static int
+executeT2(T2Extractor* e, const unsigned char* code, Py_ssize_t length)
+{
+    Py_ssize_t pos = 0;
+    int result = T2_OK;
+
+    if (++e->depth > T2_MAX_SUBR_DEPTH)
+        return T2_UNSUPPORTED;
+    while (pos < length && result == T2_OK) {
+        int b0 = code[pos++];
+        long value;
+
+        if (b0 >= 32 && b0 <= 246) {
+            value = b0 - 139;
+        } else if (b0 >= 247 && b0 <= 254) {
+            if (pos == length)
+                return T2_UNSUPPORTED;
+            if (b0 <= 250)
+                value = (b0 - 247) * 256 + code[pos++] + 108;
+            else
+                value = -(b0 - 251) * 256 - code[pos++] - 108;
+        } else if (b0 == 28) {
+            if (length - pos < 2)
+                return T2_UNSUPPORTED;
+            value = (code[pos] << 8) | code[pos + 1];
+            if (value >= 0x8000)
+                value -= 0x10000;
+            pos += 2;
+        } else if (b0 == 255) {
+            /* fontTools versions differ in how they read 16.16 numbers. */
+            return T2_UNSUPPORTED;
+        } else {
+            int op = b0;
+            if (b0 == 12) {
+                if (pos == length)
+                    return T2_UNSUPPORTED;
+                op = (b0 << 8) | code[pos++];
+            }
+            result = doT2Op(e, op, code, length, &pos);
+            continue;
+        }
+
+        if (e->stackCount == T2_MAX_STACK)
+            return T2_UNSUPPORTED;
+        e->stack[e->stackCount++] = value;
+    }
+    e->depth--;
+    return result;
+}
+
+static char t2_to_bez_doc[] =
+  "Convert a Type 2 charstring to bez format, without its hints.\n"
+  "\n"
+  "Signature:\n"
+  "  t2_to_bez(charstring, local_subrs, global_subrs[, allow_decimals])\n"
+  "\n"
+  "Args:\n"
+  "  charstring: compiled charstring of the glyph.\n"
+  "  local_subrs: list of the compiled local subroutines.\n"
+  "  global_subrs: list of the compiled global subroutines.\n"
+  "  allow_decimals: write coordinates with two decimals.\n"
+  "\n"
+  "Output:\n"
+  "  A tuple of the bez data, whether the charstring has hints, and its\n"
+  "  width operand or None if it uses the default width, the same as from\n"
+  "  BezTools.convertT2GlyphToBez with removeHints. None if the charstring\n"
+  "  has operators or operands that this function does not handle.\n";
+
+static PyObject*
+t2_to_bez(PyObject* self, PyObject* args)
+{
+    int allowDecimals = false;
+    const char* charString = NULL;
+    Py_ssize_t charStringLength = 0;
+    PyObject* localSubrs = NULL;
+    PyObject* globalSubrs = NULL;
+    PyObject* outObj = NULL;
+    T2Extractor* e;
+    int result = T2_ERROR;
+
+    if (!PyArg_ParseTuple(args, "s#OO|i", &charString, &charStringLength,
+                          &localSubrs, &globalSubrs, &allowDecimals))
+        return NULL;
+
+    e = MEMNEW(sizeof(T2Extractor));
+    if (!e)
+        return PyErr_NoMemory();
+    memset(e, 0, sizeof(T2Extractor));
+    e->allowDecimals = allowDecimals;
+
+    if (initT2Subrs(&e->localSubrs, localSubrs) &&
+        initT2Subrs(&e->globalSubrs, globalSubrs) &&
+        writeText(&e->writer, "", 0)) {
+        result = executeT2(e, (const unsigned char*)charString,
+                           charStringLength);
+        /* The Python code closes the path it ends in even without an
+         * endchar, and can not tell the width of glyphs that have none. */
+        if (result == T2_OK && !e->gotWidth)
+            result = T2_UNSUPPORTED;
+        if (result == T2_OK && e->writer.length > 0 && !e->closePathWritten &&
+            !writeBezOp(e, "cp\n"))
+            result = T2_ERROR;
+        if (result == T2_OK && !writeBezOp(e, "ed\n"))
+            result = T2_ERROR;
+    }
+
+    if (result == T2_OK && e->hasWidth) {
+        outObj = Py_BuildValue("s#Nl", e->writer.data, e->writer.length,
+                               PyBool_FromLong(e->hintCount > 0), e->width);
+    } else if (result == T2_OK) {
+        outObj = Py_BuildValue("s#NO", e->writer.data, e->writer.length,
+                               PyBool_FromLong(e->hintCount > 0), Py_None);
+    } else if (result == T2_UNSUPPORTED) {
+        outObj = Py_None;
+        Py_INCREF(outObj);
+    }
+
+    Py_XDECREF(e->localSubrs.subrs);
+    Py_XDECREF(e->globalSubrs.subrs);
+    MEMFREE(e->writer.data);
+    MEMFREE(e);
+    return outObj;
+}
+
 /* clang-format off */
 static PyMethodDef psautohint_methods[] = {
   { "autohint", autohint, METH_VARARGS, autohint_doc },
+  { "autohintmm", autohintmm, METH_VARARGS, autohintmm_doc },
+  { "memory_stats", memory_stats, METH_NOARGS, memory_stats_doc },
+  { "stem_histograms", stem_histograms, METH_VARARGS, stem_histograms_doc },
+  { "derive_fontinfo", derive_fontinfo, METH_VARARGS, derive_fontinfo_doc },
+  { "glif_to_bez", glif_to_bez, METH_VARARGS, glif_to_bez_doc },
+  { "bez_to_t2", bez_to_t2, METH_VARARGS, bez_to_t2_doc },
+  { "t2_to_bez", t2_to_bez, METH_VARARGS, t2_to_bez_doc },
   { NULL, NULL, 0, NULL }
 };
 /* clang-format on */
@@ -210,13 +3065,24 @@ static PyMethodDef psautohint_methods[] = {
 static char psautohint_doc[] =
   "Python wrapper for Adobe's PostScrupt autohinter.\n"
   "\n"
-  "autohint() -- Autohint glyphs.\n";
+  "autohint() -- Autohint glyphs.\n"
+  "autohintmm() -- Autohint the masters of a glyph together.\n"
+  "memory_stats() -- Get the memory used by the last glyph hinted.\n"
+  "stem_histograms() -- Collect the stem widths of many glyphs.\n"
+  "derive_fontinfo() -- Derive font information from the glyphs of a font.\n"
+  "glif_to_bez() -- Convert the outline of a GLIF glyph to bez format.\n"
+  "bez_to_t2() -- Convert a glyph in bez format to a Type 2 charstring.\n"
+  "t2_to_bez() -- Convert a Type 2 charstring to bez format.\n";
 
 #define SETUPMODULE                                                            \
     PyModule_AddStringConstant(m, "version", AC_getVersion());                 \
     PsAutoHintError = PyErr_NewException("psautohint.error", NULL, NULL);      \
     Py_INCREF(PsAutoHintError);                                                \
-    PyModule_AddObject(m, "error", PsAutoHintError);
+    PyModule_AddObject(m, "error", PsAutoHintError);                           \
+    PsAutoHintTimeout =                                                        \
+      PyErr_NewException("psautohint.timeout", PsAutoHintError, NULL);         \
+    Py_INCREF(PsAutoHintTimeout);                                              \
+    PyModule_AddObject(m, "timeout", PsAutoHintTimeout);
 
 #if PY_MAJOR_VERSION >= 3
 /* clang-format off */
@@ -16,7 +16,8 @@ autohint -hfd
 autohint -pfd
 autohint [-g <glyph list>] [-gf <filename>] [-xg <glyph list>] [-xgf <filename>]
          [-cf path] [-a] [-logOnly] [-log <logFile path>] [-r] [-q] [-qq] [-c]
-         [-nf] [-ns] [-nb] [-wd] [-o <output font path>] font-path
+         [-nf] [-ns] [-nb] [-draft] [-timeout <seconds>] [-wd] [-j <jobs>]
+         [-o <output font path>] font-path
 
 """
 
@@ -130,6 +131,17 @@ Options:
 -nb .. Allow the font to have to no stem widths or blue values specified.
        Without this option, autohint will complain and quit.
 
+-draft Make draft hints, for preview builds. The stem hints and alignment
+       zones are found as usual, but there is no hint substitution or flex,
+       and the refinement passes of -c are skipped. As the glyphs are then
+       recorded as hinted, use -all or -a when hinting them again at full
+       quality.
+
+-timeout <seconds>
+       Give up hinting a glyph once it has taken this many seconds of
+       processor time. The glyph is then left as it was, and is not recorded
+       as hinted.
+
 -o <output font path>
        If not specified, autohint will write the hinted output to the original
        font path name.
@@ -143,6 +155,11 @@ Options:
 -hf .. Use history file. Will create it if it does not already exist.
        Should not be used with UFO fonts, where another mechanism is employed.
 
+-hfi . Use an indexed history file, "<PostScriptName>.history", instead of the
+       plist one. It keeps a hash of each outline, and the bez data in
+       "<PostScriptName>.history.bez", which is read only for the glyphs that
+       are looked up. Implies -hf.
+
 -a ... Hint all glyphs that are in the history file, or are unhinted.
        Has effect only if the history file is being used.
 
@@ -155,6 +172,12 @@ Options:
 
 -wd .. Write changed glyphs to default layer instead of '%s'.
 
+-j <number of jobs>, --jobs <number of jobs>
+       Hint glyphs in this many processes at once; 0 uses one per CPU. The
+       outlines are still read and the font and history file still updated in
+       glyph order, so the output is the same as when hinting in a single
+       process, which is the default.
+
 autohint can also apply different sets of alignment zones while hinting a
 particular set of glyphs. This is useful for name-keyed fonts, which, unlike
 CID fonts, only have one set of global alignment zones and stem widths.
@@ -461,9 +484,12 @@ import os
 import re
 import time
 import plistlib
+import hashlib
 import warnings
 import traceback
 import shutil
+import multiprocessing
+from collections import deque
 
 from psautohint import _psautohint
 from psautohint import ufoTools
@@ -472,6 +498,9 @@ kACIDKey = "AutoHintKey"
 
 gLogFile = None
 kFontPlistSuffix = ".plist"
+kIndexedHistorySuffix = ".history"
+kIndexedHistoryBezSuffix = ".history.bez"
+kTempSuffix = ".tmp"
 kTempCFFSuffix = ".temp.ac.cff"
 
 class ACOptions:
@@ -481,6 +510,7 @@ class ACOptions:
 		self.glyphList = []
 		self.excludeGlyphList = 0
 		self.usePlistFile = 0
+		self.useIndexedHistory = 0
 		self.hintAll = 0
 		self.rehint = 0
 		self.verbose = 1
@@ -488,6 +518,8 @@ class ACOptions:
 		self.allowChanges = 0
 		self.noFlex = 0
 		self.noHintSub = 0
+		self.draft = 0
+		self.timeLimit = 0
 		self.allow_no_blues = 0
 		self.hCounterGlyphs = []
 		self.vCounterGlyphs = []
@@ -499,6 +531,7 @@ class ACOptions:
 		self.debug = 0
 		self.allowDecimalCoords = 0
 		self.writeToDefaultLayer = 0
+		self.jobs = 1
 
 class ACOptionParseError(KeyError):
 	pass
@@ -661,6 +694,9 @@ def getOptions(args=None):
 			options.printFDDictList = 1
 		elif arg == "-hf":
 			options.usePlistFile = 1
+		elif arg == "-hfi":
+			options.usePlistFile = 1
+			options.useIndexedHistory = 1
 		elif arg == "-a":
 			options.hintAll = 1
 		elif arg == "-all":
@@ -680,6 +716,16 @@ def getOptions(args=None):
 			options.noHintSub = 1
 		elif arg == "-nb":
 			options.allow_no_blues = 1
+		elif arg == "-draft":
+			options.draft = 1
+		elif arg == "-timeout":
+			i = i +1
+			try:
+				options.timeLimit = float(args[i])
+			except (IndexError, ValueError):
+				options.timeLimit = -1
+			if options.timeLimit <= 0:
+				raise ACOptionParseError("Option Error: '-timeout' must be followed by a number of seconds.")
 		elif arg in ["-xg", "-g"]:
 			if arg == "-xg":
 				options.excludeGlyphList = 1
@@ -727,6 +773,16 @@ def getOptions(args=None):
 			options.allowDecimalCoords = True
 		elif arg =="-wd":
 			options.writeToDefaultLayer = 1
+		elif arg in ["-j", "--jobs"]:
+			i = i +1
+			try:
+				options.jobs = int(args[i])
+			except (IndexError, ValueError):
+				options.jobs = -1
+			if options.jobs < 0:
+				raise ACOptionParseError("Option Error: '%s' must be followed by a number of jobs." % arg)
+			if options.jobs == 0:
+				options.jobs = multiprocessing.cpu_count()
 		elif arg[0] == "-":
 			raise ACOptionParseError("Option Error: Unknown option <%s>." % arg)
 		else:
@@ -847,7 +903,188 @@ def openFontPlistFile(psName, dirPath):
 		fontPlist = plistlib.Plist()
 	if kACIDKey not in fontPlist:
 		fontPlist[kACIDKey] = {}
-	return fontPlist, filePath, isNewPlistFile
+	return PlistHintHistory(fontPlist), filePath, isNewPlistFile
+
+
+class PlistHintHistory:
+	"""
+	The hint history in the plist file, which keeps the outline identifier
+	and the bez data of every glyph.
+	"""
+	def __init__(self, fontPlist):
+		self.fontPlist = fontPlist
+
+	def identify(self, ACidentifier):
+		return ACidentifier
+
+	def getEntry(self, name):
+		# Returns (ACidentifier, ACtime, bezString, hintBezString); older
+		# entries have no bez data. Raises KeyError if there is no entry.
+		entry = self.fontPlist[kACIDKey][name]
+		if len(entry) == 2:
+			return entry[0], entry[1], "", ""
+		return tuple(entry)
+
+	def setEntry(self, name, ACidentifier, ACtime, bezString, hintBezString):
+		self.fontPlist[kACIDKey][name] = (ACidentifier, ACtime, bezString, hintBezString)
+
+	def write(self, filePath):
+		self.fontPlist.write(filePath)
+
+
+def openIndexedHistoryFile(psName, dirPath):
+	filePath = os.path.join(dirPath, psName + kIndexedHistorySuffix)
+	history = IndexedHintHistory(filePath, os.path.join(dirPath, psName + kIndexedHistoryBezSuffix))
+	isNewHistoryFile = 1
+	if os.path.exists(filePath):
+		try:
+			history.read()
+			isNewHistoryFile = 0
+		except (IOError, OSError):
+			raise ACFontError("\tError: font history file exists, but coud not be read <%s>." % filePath)
+		except ValueError:
+			raise ACFontError("\tError: font history file exists, but coud not be parsed <%s>." % filePath)
+	return history, filePath, isNewHistoryFile
+
+
+class IndexedHintHistory:
+	"""
+	The hint history in an index file, with one line per glyph:
+		G<tab>name<tab>outline hash<tab>time<tab>bez hash<tab>hinted bez hash
+	and one line per bez string:
+		B<tab>bez hash<tab>offset<tab>length
+	The bez strings are kept once each in the bez file, which is only
+	appended to until it holds more unused data than used, and are read
+	when a glyph is looked up. Appending leaves the offsets of the index
+	valid; a rewritten bez file and the index are written to temporary
+	files and renamed over the old ones, and the bez strings read are
+	checked against their hash, so that an interrupted run can't make a
+	glyph get another glyph's data.
+	"""
+	def __init__(self, filePath, bezFilePath):
+		self.filePath = filePath
+		self.bezFilePath = bezFilePath
+		self.glyphs = {} # name -> index line fields
+		self.blobs = {} # bez hash -> (offset, length)
+		self.newBlobs = {} # bez hash -> bez string, not yet in the bez file
+		self.bezFile = None
+
+	def read(self):
+		fp = open(self.filePath, "rt")
+		for line in fp:
+			fields = line.rstrip("\r\n").split("\t")
+			if fields[0] == "G" and len(fields) == 6:
+				self.glyphs[fields[1]] = fields[2:]
+			elif fields[0] == "B" and len(fields) == 4:
+				self.blobs[fields[1]] = (int(fields[2]), int(fields[3]))
+			elif fields != [""]:
+				fp.close()
+				raise ValueError("bad history line")
+		fp.close()
+
+	def identify(self, ACidentifier):
+		return hashBezString(ACidentifier)
+
+	def getEntry(self, name):
+		ACidentifier, ACtime, bezHash, hintBezHash = self.glyphs[name]
+		return ACidentifier, ACtime, self.getBezString(bezHash), self.getBezString(hintBezHash)
+
+	def setEntry(self, name, ACidentifier, ACtime, bezString, hintBezString):
+		self.glyphs[name] = [ACidentifier, ACtime, self.addBezString(bezString), self.addBezString(hintBezString)]
+
+	def getBezString(self, bezHash):
+		if bezHash in self.newBlobs:
+			return self.newBlobs[bezHash]
+		try:
+			offset, length = self.blobs[bezHash]
+		except KeyError:
+			return "" # lost bez data just means hinting the glyph again.
+		if self.bezFile == None:
+			self.bezFile = open(self.bezFilePath, "rb")
+		self.bezFile.seek(offset)
+		data = self.bezFile.read(length)
+		if len(data) != length:
+			return ""
+		try:
+			bezString = data.decode("utf-8")
+		except UnicodeDecodeError:
+			return ""
+		if hashBezString(bezString) != bezHash:
+			return ""
+		return bezString
+
+	def addBezString(self, bezString):
+		bezHash = hashBezString(bezString)
+		if bezHash not in self.blobs and bezHash not in self.newBlobs:
+			self.newBlobs[bezHash] = bezString
+		return bezHash
+
+	def write(self, filePath):
+		# Drop the bez strings no glyph uses any more, and rewrite the bez
+		# file once they take more room than the used ones.
+		usedHashes = set()
+		for fields in self.glyphs.values():
+			usedHashes.add(fields[2])
+			usedHashes.add(fields[3])
+		blobs = dict((bezHash, self.blobs[bezHash]) for bezHash in usedHashes if bezHash in self.blobs)
+		usedSize = sum(length for offset, length in blobs.values())
+		if self.bezFile != None:
+			self.bezFile.close()
+			self.bezFile = None
+		bezFileSize = 0
+		if os.path.exists(self.bezFilePath):
+			bezFileSize = os.path.getsize(self.bezFilePath)
+		if bezFileSize > 2 * usedSize:
+			newBlobs = dict((bezHash, self.getBezString(bezHash)) for bezHash in blobs)
+			if self.bezFile != None:
+				self.bezFile.close()
+				self.bezFile = None
+			blobs = {}
+			bezFileSize = 0
+			bezFilePath = self.bezFilePath + kTempSuffix
+			fp = open(bezFilePath, "wb")
+		else:
+			newBlobs = {}
+			bezFilePath = None
+			fp = open(self.bezFilePath, "ab")
+		newBlobs.update((bezHash, bezString) for bezHash, bezString in self.newBlobs.items() if bezHash in usedHashes)
+		for bezHash in sorted(newBlobs):
+			data = newBlobs[bezHash].encode("utf-8")
+			fp.write(data)
+			blobs[bezHash] = (bezFileSize, len(data))
+			bezFileSize += len(data)
+		fp.close()
+		if bezFilePath != None:
+			replaceFile(bezFilePath, self.bezFilePath)
+		self.blobs = blobs
+		self.newBlobs = {}
+
+		lines = []
+		for name in sorted(self.glyphs):
+			lines.append("\t".join(["G", name] + self.glyphs[name]))
+		for bezHash in sorted(self.blobs):
+			offset, length = self.blobs[bezHash]
+			lines.append("B\t%s\t%d\t%d" % (bezHash, offset, length))
+		lines.append("")
+		fp = open(filePath + kTempSuffix, "wt")
+		fp.write("\n".join(lines))
+		fp.close()
+		replaceFile(filePath + kTempSuffix, filePath)
+
+
+def hashBezString(bezString):
+	return hashlib.sha1(bezString.encode("utf-8")).hexdigest()
+
+
+def replaceFile(tempPath, filePath):
+	"""Renames tempPath to filePath, replacing it. On Windows, Python 2 can
+	only rename to a path that doesn't exist."""
+	if hasattr(os, "replace"):
+		os.replace(tempPath, filePath)
+	else:
+		if os.name == "nt" and os.path.exists(filePath):
+			os.remove(filePath)
+		os.rename(tempPath, filePath)
 
 
 fontInfoKeywordList = [
@@ -924,6 +1161,118 @@ def makeACIdentifier(bezText):
 	return bezText
 
 
+# Glyph names which the autohint library treats specially (see the lists in
+# libpsautohint/src/charprop.c). Their hints depend on the name as well as on
+# the outline, so the name has to be part of the translation key.
+kNameDependentGlyphs = frozenset([
+	"m", "M", "T", "ellipsis", "element", "equivalence", "notelement",
+	"divide", "questiondown", "exclamdown", "semicolon", "question", "exclam",
+	"colon", "at", "bullet", "copyright", "currency", "registered",
+	"asciitilde", "asterisk", "period", "periodcentered", "dieresis",
+	"guillemotleft", "guillemotright", "guilsinglleft", "guilsinglright",
+	"quotesingle", "quotedbl", "quotedblbase", "quotesinglbase", "quoteleft",
+	"quoteright", "quotedblleft", "quotedblright", "tilde", "i", "j",
+	"percent", "perthousand",
+	])
+
+# The library drops the hints of a path element that is shorter than this
+# (see RemShortColors in libpsautohint/src/auto.c), measuring the first
+# element from the origin. Subpaths may be reordered, so outlines with any
+# subpath starting this close to 0,0 are not translation invariant.
+kMinColorElementLength = 12
+
+# Indices of the x coordinate arguments of the absolute bez operators written
+# by the autohint library. Operators whose arguments are all y values or
+# counts map to an empty tuple.
+kBezXArgs = {
+	"mt": (0,), "dt": (0,), "ct": (0, 2, 4), "rmt": (0,),
+	"ry": (0,), "rm": (0,), "rb": (), "rv": (), "id": (),
+	"flxa": (0, 2, 4, 6, 8, 10, 15),
+	}
+
+
+def makeTranslationKey(bezText):
+	# Return a key which is the same for all outlines that differ only by a
+	# horizontal offset, and the x origin of this outline relative to that key.
+	# y values are kept as they are, so two outlines with the same key always
+	# have the same relationship to the alignment zones.
+	# Returns (None, 0) if the outline cannot be canonicalized.
+	keyList = []
+	xOrigin = None
+	for line in bezText.splitlines():
+		line = line.split("%")[0]
+		tokens = line.split()
+		args = []
+		for token in tokens:
+			if token in ("sc", "cp", "ed"):
+				if args:
+					return None, 0
+				keyList.append(token)
+			elif token in ("mt", "dt", "ct"):
+				if token == "mt" and \
+						abs(args[0]) < kMinColorElementLength and \
+						abs(args[1]) < kMinColorElementLength:
+					return None, 0
+				if xOrigin is None:
+					xOrigin = args[0]
+				for i in kBezXArgs[token]:
+					args[i] -= xOrigin
+				keyList.extend([str(arg) for arg in args])
+				keyList.append(token)
+				args = []
+			else:
+				try:
+					args.append(int(token))
+				except ValueError:
+					# Decimal coordinates, or an operator we do not shift.
+					return None, 0
+	if args or xOrigin is None:
+		return None, 0
+	return " ".join(keyList), xOrigin
+
+
+def translateBez(bezText, dx, glyphName):
+	# Shift the outline and hints of a hinted bez string, as written by the
+	# autohint library, by dx units horizontally, and give it a new name.
+	# Returns None if the data contains anything that cannot be shifted.
+	newLines = []
+	for line in bezText.splitlines():
+		if line.startswith("%"):
+			newLines.append("%% %s" % glyphName)
+			continue
+		comment = ""
+		if "%" in line:
+			line, comment = line.split("%", 1)
+			comment = "%" + comment
+		tokens = line.split()
+		newTokens = []
+		args = []
+		for token in tokens:
+			if token[0].isdigit() or token[0] == "-":
+				args.append(token)
+				continue
+			if args:
+				try:
+					xArgs = kBezXArgs[token]
+				except KeyError:
+					return None
+				for i in xArgs:
+					try:
+						args[i] = str(int(args[i]) + dx)
+					except (ValueError, IndexError):
+						return None
+				newTokens.extend(args)
+				args = []
+			newTokens.append(token)
+		if args:
+			return None
+		if comment:
+			newTokens.append(comment)
+		newLines.append(" ".join(newTokens))
+	newLines.append("")
+	return "\n".join(newLines)
+
+
 def openFile(path, outFilePath, useHashMap, options):
 	if os.path.isfile(path):
 		font = openOpenTypeFile(path, outFilePath, options)
@@ -1047,6 +1396,36 @@ def cmpFDDictEntries(entry1, entry2):
 		return 0
 
 
+class ACHintResult:
+	"""The result of hinting a glyph in this process, with the same get() as
+	the results of hinting in a pool."""
+	def __init__(self, bezString):
+		self.bezString = bezString
+
+	def get(self):
+		return self.bezString
+
+
+def hintGlyph(name, fontInfo, bezString, verbose, allowChanges, allowHintSub, allowDecimalCoords, draft, timeLimit):
+	"""Returns the hinted bez string, or None if hinting the glyph took longer
+	than timeLimit. Raises ACHintError if the library fails on the glyph."""
+	try:
+		newBezString = _psautohint.autohint(fontInfo.encode("ascii"), [bezString.encode("ascii")],
+                                            verbose, allowChanges, allowHintSub, allowDecimalCoords,
+                                            False, draft, timeLimit)
+	except _psautohint.timeout:
+		return None
+	except _psautohint.error as e:
+		# The same error whether or not the glyph is hinted in a pool, where
+		# the library's exception can't be sent back to the parent process.
+		raise ACHintError("%s Error - %s" % (aliasName(name), e))
+	return newBezString[0].decode("ascii")
+
+
+def hintGlyphInPool(args):
+	return hintGlyph(*args)
+
+
 def hintFile(options):
 
 	path = options.inputPath
@@ -1080,7 +1459,10 @@ def hintFile(options):
 	psName = fontData.getPSName()
 
 	if (not options.logOnly) and options.usePlistFile:
-		fontPlist, fontPlistFilePath, isNewPlistFile = openFontPlistFile(psName, os.path.dirname(path))
+		if options.useIndexedHistory:
+			hintHistory, fontPlistFilePath, isNewPlistFile = openIndexedHistoryFile(psName, os.path.dirname(path))
+		else:
+			hintHistory, fontPlistFilePath, isNewPlistFile = openFontPlistFile(psName, os.path.dirname(path))
 		if isNewPlistFile and not (options.hintAll or options.rehint):
 			logMsg("No hint info plist file was found, so all glyphs are unknown to autohint. To hint all glyphs, run autohint again with option -a to hint all glyphs unconditionally.")
 			logMsg("Done with font %s. End time: %s." % (path, time.asctime()))
@@ -1151,7 +1533,6 @@ def hintFile(options):
 	# Get charstring for identifier in glyph-list
 	removeHints = 1
 	isCID = fontData.isCID()
-	lastFDIndex = None
 	anyGlyphChanged = 0
 	pListChanged = 0
 	if isCID:
@@ -1179,109 +1560,41 @@ def hintFile(options):
 	else:
 		decimalArg = ""
 
-	dotCount = 0
-	seenGlyphCount = 0
-	processedGlyphCount = 0
-	for name in glyphList:
-		prevACIdentifier = None
-		seenGlyphCount += 1
-
-		# Convert to bez format
-		bezString, width, hasHints = fontData.convertToBez(name, removeHints,
-											options.verbose, options.hintAll)
-		processedGlyphCount += 1
-		if bezString == None:
-			continue
-
-		if "mt" not in bezString:
-			# skip empty glyphs.
-			continue
-		# get new fontinfo string if FDarray index has changed,
-		# as each FontDict has different alignment zones.
-		gid = fontData.getGlyphID(name)
-		if isCID: #
-			fdIndex = fontData.getfdIndex(gid)
-			if not fdIndex == lastFDIndex:
-				lastFDIndex = fdIndex
-				fdDict = fontData.getFontInfo(psName, path,
-												options.allow_no_blues,
-												options.noFlex,
-												options.vCounterGlyphs,
-												options.hCounterGlyphs,
-												fdIndex)
-				fontInfo = fdDict.getFontInfo()
-		else:
-			if (fdGlyphDict != None):
-				try:
-					fdIndex = fdGlyphDict[name][0]
-				except KeyError:
-					# use default dict.
-					fdIndex = 0
-				if lastFDIndex != fdIndex:
-					lastFDIndex = fdIndex
-					fdDict = fontDictList[fdIndex]
-					fontInfo = fdDict.getFontInfo()
-
-
-		# 	Build autohint point list identifier
-
-		oldBezString = ""
-		oldHintBezString = ""
-		if (not options.logOnly) and options.usePlistFile:
-			# If the glyph is not in the plist file, then we skip it unless
-			# kReHintUnknown is set.
-			# If the glyph is in the plist file and the outline has changed,
-			# we hint it.
-			ACidentifier = makeACIdentifier(bezString)
-			try:
-				(prevACIdentifier, ACtime, oldBezString, oldHintBezString) = fontPlist[kACIDKey][name]
-			except ValueError:
-				(prevACIdentifier, ACtime) = fontPlist[kACIDKey][name]
-				oldBezString = oldHintBezString = ""
-			except KeyError:
-				# there wasn't an entry in tempList file, so we will add one.
-				pListChanged = 1
-				if hasHints and not options.rehint:
-					# Glyphs is hinted, but not referenced in the plist file.
-					# Skip it unless options.rehint is seen
-					if not isNewPlistFile:
-						# Comment only if there is a plist file; otherwise, we'd
-						# be complaining for almost every glyph.
-						logMsg("%s Skipping glyph - it has hints, but it is not in the hint info plist file." % aliasName(name))
-						dotCount = 0
-					continue
-			# there's an entry in the plist file and it matches what's in the font
-			if prevACIdentifier and (prevACIdentifier == ACidentifier):
-				if hasHints and not (options.hintAll or options.rehint):
-					continue
-			else:
-				pListChanged = 1
-
-		if options.verbose:
-			if fdGlyphDict:
-				logMsg("Hinting %s with fdDict %s." % (aliasName(name), fdDict.DictName))
-			else:
-				logMsg("Hinting %s." % aliasName(name))
-		elif not options.quiet:
-			logMsg(".,")
-			dotCount += 1
-			if dotCount > 40:
-				dotCount = 0
-				logMsg("") # I do this to never have more than 40 dots on a line.
-				# This in turn give reasonable performance when calling autohint
-				# in a subprocess and getting output with std.readline()
-
-		# Call auto-hint library on bez string.
-		#print("oldBezString", oldBezString)
-		#print("")
-		#print("bezString", bezString)
-
-		if oldBezString != "" and oldBezString == bezString:
-			newBezString = oldHintBezString
-		else:
-			newBezString = _psautohint.autohint(fontInfo.encode("ascii"), [bezString.encode("ascii")],
-                                        options.verbose, options.allowChanges, not options.noHintSub, options.allowDecimalCoords)
-			newBezString = newBezString[0].decode("ascii")
+	# Hinted results of outlines seen so far in this run, keyed by fontinfo
+	# and translation key, so that glyphs which differ only by a horizontal
+	# offset are hinted once.
+	hintCache = {}
+	fontInfoNames = {}
+
+	# With more than one job, the glyphs are hinted in a pool of processes,
+	# while this one keeps reading outlines ahead. The hinted glyphs are
+	# committed in glyph order, so the output does not depend on the jobs.
+	pool = None
+	window = 0
+	if options.jobs > 1:
+		pool = multiprocessing.Pool(options.jobs)
+		window = 4 * options.jobs
+	pending = deque()
+
+	def commitGlyph(name, width, prevACIdentifier, result, dx, args):
+		"""Updates the font and the hint history with a hinted glyph.
+		Returns whether the font was updated, and whether a message was
+		logged."""
+		newBezString = result.get()
+		if dx is not None:
+			if newBezString is not None:
+				newBezString = translateBez(newBezString, dx, name)
+			if newBezString is None:
+				# The cached result timed out or can't be shifted, hint this
+				# glyph itself.
+				newBezString = hintGlyph(*args)
+
+		if newBezString is None:
+			# Hinting ran out of time; the font and history are not updated.
+			if not options.verbose and not options.quiet:
+				logMsg("")
+			logMsg("\t%s Hinting took longer than %g seconds, the glyph is left as it was." % (aliasName(name), options.timeLimit))
+			return False, True
 
 		if not newBezString:
 			if not options.verbose and not options.quiet:
@@ -1292,23 +1605,185 @@ def hintFile(options):
 			print("No hints added!")
 
 		if options.logOnly:
-			continue
+			return False, False
 
 		# Convert bez to charstring, and update CFF.
-		anyGlyphChanged = 1
 		fontData.updateFromBez(newBezString, name, width, options.verbose)
 
-
+		logged = False
 		if options.usePlistFile:
 			bezString = "%% %s%s%s" % (name, os.linesep, newBezString)
-			ACidentifier = makeACIdentifier(bezString)
+			ACidentifier = hintHistory.identify(makeACIdentifier(bezString))
 			# add glyph hint entry to plist file
 			if options.allowChanges:
 				if prevACIdentifier and (prevACIdentifier != ACidentifier):
 					logMsg("\t%s Glyph outline changed" % aliasName(name))
+					logged = True
+
+			hintHistory.setEntry(name, ACidentifier, time.asctime(), bezString, newBezString)
+		return True, logged
+
+	# The FDDict and fontinfo string of each font dict, made the first time
+	# a glyph uses the dict. Glyphs of different dicts are often interleaved
+	# in CID fonts, so they are not rebuilt whenever the dict changes.
+	fdFontInfos = {}
+
+	def getFDFontInfo(fdIndex):
+		try:
+			return fdFontInfos[fdIndex]
+		except KeyError:
+			pass
+		if isCID:
+			fdDict = fontData.getFontInfo(psName, path,
+											options.allow_no_blues,
+											options.noFlex,
+											options.vCounterGlyphs,
+											options.hCounterGlyphs,
+											fdIndex)
+		else:
+			fdDict = fontDictList[fdIndex]
+		fdFontInfos[fdIndex] = (fdDict, fdDict.getFontInfo())
+		return fdFontInfos[fdIndex]
+
+	dotCount = 0
+	seenGlyphCount = 0
+	processedGlyphCount = 0
+	try:
+		for name in glyphList:
+			prevACIdentifier = None
+			seenGlyphCount += 1
+
+			# Convert to bez format
+			bezString, width, hasHints = fontData.convertToBez(name, removeHints,
+												options.verbose, options.hintAll)
+			processedGlyphCount += 1
+			if bezString == None:
+				continue
+
+			if "mt" not in bezString:
+				# skip empty glyphs.
+				continue
+			# get new fontinfo string if FDarray index has changed,
+			# as each FontDict has different alignment zones.
+			gid = fontData.getGlyphID(name)
+			if isCID: #
+				fdIndex = fontData.getfdIndex(gid)
+				fdDict, fontInfo = getFDFontInfo(fdIndex)
+			else:
+				if (fdGlyphDict != None):
+					try:
+						fdIndex = fdGlyphDict[name][0]
+					except KeyError:
+						# use default dict.
+						fdIndex = 0
+					fdDict, fontInfo = getFDFontInfo(fdIndex)
+
+
+			# 	Build autohint point list identifier
+
+			oldBezString = ""
+			oldHintBezString = ""
+			if (not options.logOnly) and options.usePlistFile:
+				# If the glyph is not in the plist file, then we skip it unless
+				# kReHintUnknown is set.
+				# If the glyph is in the plist file and the outline has changed,
+				# we hint it.
+				ACidentifier = hintHistory.identify(makeACIdentifier(bezString))
+				try:
+					(prevACIdentifier, ACtime, oldBezString, oldHintBezString) = hintHistory.getEntry(name)
+				except KeyError:
+					# there wasn't an entry in tempList file, so we will add one.
+					pListChanged = 1
+					if hasHints and not options.rehint:
+						# Glyphs is hinted, but not referenced in the plist file.
+						# Skip it unless options.rehint is seen
+						if not isNewPlistFile:
+							# Comment only if there is a plist file; otherwise, we'd
+							# be complaining for almost every glyph.
+							logMsg("%s Skipping glyph - it has hints, but it is not in the hint info plist file." % aliasName(name))
+							dotCount = 0
+						continue
+				# there's an entry in the plist file and it matches what's in the font
+				if prevACIdentifier and (prevACIdentifier == ACidentifier):
+					if hasHints and not (options.hintAll or options.rehint):
+						continue
+				else:
+					pListChanged = 1
+
+			if options.verbose:
+				if fdGlyphDict:
+					logMsg("Hinting %s with fdDict %s." % (aliasName(name), fdDict.DictName))
+				else:
+					logMsg("Hinting %s." % aliasName(name))
+			elif not options.quiet:
+				logMsg(".,")
+				dotCount += 1
+				if dotCount > 40:
 					dotCount = 0
+					logMsg("") # I do this to never have more than 40 dots on a line.
+					# This in turn give reasonable performance when calling autohint
+					# in a subprocess and getting output with std.readline()
 
-			fontPlist[kACIDKey][name] = (ACidentifier, time.asctime(), bezString, newBezString)
+			# Call auto-hint library on bez string.
+			#print("oldBezString", oldBezString)
+			#print("")
+			#print("bezString", bezString)
+
+			if oldBezString != "" and oldBezString == bezString:
+				result, dx, args = ACHintResult(oldHintBezString), None, None
+			else:
+				result, dx = None, None
+				args = (name, fontInfo, bezString, options.verbose, options.allowChanges,
+						not options.noHintSub, options.allowDecimalCoords, options.draft,
+						options.timeLimit)
+				cacheKey, xOrigin = makeTranslationKey(bezString)
+				if cacheKey is not None:
+					# Counter glyphs are named in the fontinfo, and some other
+					# glyphs are hinted by name; those never share results.
+					try:
+						infoNames = fontInfoNames[fontInfo]
+					except KeyError:
+						infoNames = fontInfoNames[fontInfo] = frozenset(fontInfo.split())
+					if name in kNameDependentGlyphs or name in infoNames:
+						cacheKey = (fontInfo, cacheKey, name)
+					else:
+						cacheKey = (fontInfo, cacheKey)
+					try:
+						cachedOrigin, result = hintCache[cacheKey]
+					except KeyError:
+						pass
+					else:
+						dx = xOrigin - cachedOrigin
+				if result is None:
+					if pool is None:
+						result = ACHintResult(hintGlyph(*args))
+						if result.get() is None:
+							# Timed out; copies of this glyph are tried
+							# themselves.
+							cacheKey = None
+					else:
+						result = pool.apply_async(hintGlyphInPool, (args,))
+					if cacheKey is not None:
+						hintCache[cacheKey] = (xOrigin, result)
+
+			pending.append((name, width, prevACIdentifier, result, dx, args))
+			while len(pending) > window:
+				changed, logged = commitGlyph(*pending.popleft())
+				if changed:
+					anyGlyphChanged = 1
+				if logged:
+					dotCount = 0
+
+		while pending:
+			changed, logged = commitGlyph(*pending.popleft())
+			if changed:
+				anyGlyphChanged = 1
+			if logged:
+				dotCount = 0
+	finally:
+		if pool is not None:
+			pool.terminate()
+			pool.join()
 
 	if not options.verbose and not options.quiet:
 		print("") # print final new line after progress dots.
@@ -1335,7 +1810,7 @@ def hintFile(options):
 				logMsg("No glyphs were hinted.")
 	if options.usePlistFile and (anyGlyphChanged or pListChanged):
 		# save font plist file.
-		fontPlist.write(fontPlistFilePath)
+		hintHistory.write(fontPlistFilePath)
 	if processedGlyphCount != seenGlyphCount:
 		logMsg("Skipped %s of %s glyphs." % (seenGlyphCount - processedGlyphCount, seenGlyphCount))
 	if not options.quiet:
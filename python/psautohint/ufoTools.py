@@ -297,6 +297,8 @@ Example from "B" in SourceCodePro-Regular
 
 import re
 import os
+import ast
+import json
 import plistlib
 import hashlib
 
@@ -306,6 +308,7 @@ except ImportError:
 	import xml.etree.ElementTree as ET
 
 from psautohint import ConvertFontToCID
+from psautohint import _psautohint
 
 XML = ET.XML
 XMLElement = ET.Element
@@ -328,6 +331,11 @@ kPublicGlyphOrderKey = "public.glyphOrder"
 
 kAdobeDomainPrefix = "com.adobe.type"
 kAdobHashMapName = "%s.processedHashMap" % (kAdobeDomainPrefix)
+# The size, mtime and inode of the GLIF file of each glyph and of its
+# components when its source hash was last computed, so that unchanged
+# glyphs can be skipped without reading them.
+kAdobHashMapStatName = "%s.stat" % (kAdobHashMapName)
+kAdobHashMapStatVersion = 1
 kAdobHashMapVersionName = "hashMapVersion"
 kAdobHashMapVersion = (1,0) # If major version differs, do not use.
 kAutohintName = "autohint"
@@ -369,6 +377,30 @@ class UFOParseError(ValueError):
 class BezParseError(ValueError):
 	pass
 
+def getFileStamp(path):
+	fileStat = os.stat(path)
+	return (fileStat.st_size, fileStat.st_mtime, fileStat.st_ino)
+
+class ComponentGlyph:
+	# A GLIF file used as a component, read once and kept as long as the
+	# file does not change, since the same base glyphs are used by many
+	# composites.
+	def __init__(self, path, fileStamp):
+		self.path = path
+		self.fileStamp = fileStamp
+		fp = open(path, "rb")
+		self.glifData = fp.read()
+		fp.close()
+		self.outlineXML = None
+		self.parsed = False
+		self.hashData = {} # useDefaultGlyphDir -> UFOFontData.getOutlineHashData result
+
+	def getOutline(self):
+		if not self.parsed:
+			self.outlineXML = XML(self.glifData).find("outline")
+			self.parsed = True
+		return self.outlineXML
+
 class UFOFontData:
 	def __init__(self, parentPath, useHashMap, programName):
 		self.parentPath = parentPath
@@ -384,6 +416,9 @@ class UFOFontData:
 		self.programName = programName
 		self.curSrcDir = None
 		self.hashMapChanged = 0
+		self.changedHashEntries = set() # glyph names of entries changed since the hash map was saved.
+		self.statMap = None # glyph name -> [file stamp, source hash, [[component name, file stamp], ...]]
+		self.statMapChanged = 0
 		self.glyphDefaultDir = os.path.join(parentPath, "glyphs")
 		self.glyphLayerDir = os.path.join(parentPath, kProcessedGlyphsLayer)
 		self.glyphWriteDir = self.glyphLayerDir
@@ -394,6 +429,7 @@ class UFOFontData:
 		self.doAll = False # if True, then do not skip any glyphs.
 		self.deletedGlyph = False # track whether checkSkipGLyph has deleted a out of date glyph from the processed glyph layer
 		self.allowDecimalCoords = False # if true, do NOT round x,y values when processing.
+		self.componentCache = {} # GLIF file path -> ComponentGlyph
 
 	def getUnitsPerEm(self):
 		unitsPerEm = "1000"
@@ -429,7 +465,9 @@ class UFOFontData:
 	def convertToBez(self, glyphName, removeHints, beVerbose, doAll = 0):
 		# convertGLIFToBez does not yet support hints - no need for removeHints arg.
 		bezString, width = convertGLIFToBez(self, glyphName, beVerbose, doAll)
-		hasHints = self.checkForHints(glyphName)
+		hasHints = 0
+		if bezString != None:
+			hasHints = self.checkForHints(glyphName)
 		return bezString, width, hasHints
 
 	def updateFromBez(self, bezData, glyphName, width, beVerbose):
@@ -441,6 +479,8 @@ class UFOFontData:
 		if self.hashMapChanged:
 			self.writeHashMap()
 		self.hashMapChanged = 0
+		if self.statMapChanged:
+			self.writeStatMap()
 
 		if not os.path.exists(self.glyphWriteDir):
 			os.makedirs(self.glyphWriteDir)
@@ -480,12 +520,20 @@ class UFOFontData:
 		return self.glyphMap
 
 	def readHashMap(self):
-		hashPath = os.path.join(self.parentPath, "data", kAdobHashMapName)
+		hashDir = os.path.join(self.parentPath, "data")
+		hashPath = os.path.join(hashDir, kAdobHashMapName)
 		if os.path.exists(hashPath):
 			fp = open(hashPath, "rt")
 			data = fp.read()
 			fp.close()
-			newMap = eval(data)
+			newMap = parseHashMapLines(data)
+			if newMap is None:
+				try:
+					newMap = ast.literal_eval(data)
+				except (SyntaxError, TypeError, ValueError):
+					newMap = None
+				if not isinstance(newMap, dict):
+					raise UFOParseError("Could not parse hash map '%s'." % (hashPath))
 		else:
 			newMap = {kAdobHashMapVersionName:kAdobHashMapVersion}
 
@@ -500,31 +548,102 @@ class UFOFontData:
 			print("Updating hash map: was older version")
 			newMap = {kAdobHashMapVersionName:kAdobHashMapVersion}
 		self.hashMap = newMap
+		self.changedHashEntries = set()
 		return
 
+	def setHashEntry(self, glyphName, srcHash, historyList):
+		hashEntry = [srcHash, historyList]
+		if self.hashMap.get(glyphName) != hashEntry:
+			self.hashMap[glyphName] = hashEntry
+			self.changedHashEntries.add(glyphName)
+			self.hashMapChanged = 1
+
 	def writeHashMap(self):
 		hashMap = self.hashMap
 		if len(hashMap) == 0:
 			return # no glyphs were processed.
+		if len(self.changedHashEntries) == 0:
+			return # the file is up to date.
 
 		hashDir = os.path.join(self.parentPath, "data")
 		if not os.path.exists(hashDir):
 			os.makedirs(hashDir)
 		hashPath = os.path.join(hashDir, kAdobHashMapName)
 
+		# The map is always written in full, as the other FDK tools read it
+		# and it must not go stale. There is no indexed store next to it:
+		# writing the map would still cost as much with one.
 		hasMapKeys = hashMap.keys()
 		hasMapKeys = sorted(hasMapKeys)
 		data = ["{"]
 		for gName in hasMapKeys:
-			data.append("'%s': %s," % (gName, hashMap[gName]))
+			data.append(formatHashEntry(gName, hashMap[gName]))
 		data.append("}")
 		data.append("")
 		data = os.linesep.join(data)
 		fp = open(hashPath, "wt")
 		fp.write(data)
 		fp.close()
+		self.changedHashEntries = set()
 		return
 
+	def readStatMap(self):
+		self.statMap = {}
+		statPath = os.path.join(self.parentPath, "data", kAdobHashMapStatName)
+		if os.path.exists(statPath):
+			fp = open(statPath, "rt")
+			try:
+				data = json.load(fp)
+			except ValueError:
+				data = None # just hash the glyphs again.
+			fp.close()
+			if isinstance(data, dict) and data.get("version") == kAdobHashMapStatVersion:
+				self.statMap = data.get("glyphs", {})
+
+	def writeStatMap(self):
+		hashDir = os.path.join(self.parentPath, "data")
+		if not os.path.exists(hashDir):
+			os.makedirs(hashDir)
+		statPath = os.path.join(hashDir, kAdobHashMapStatName)
+		data = {"version": kAdobHashMapStatVersion, "glyphs": self.statMap}
+		fp = open(statPath, "wt")
+		json.dump(data, fp, sort_keys=True, separators=(",", ":"))
+		fp.close()
+		self.statMapChanged = 0
+
+	def getStatHash(self, glyphName, glyphPath):
+		# Returns the source hash of the glyph if neither its file nor those
+		# of its components have changed since it was computed, else None.
+		if self.statMap is None:
+			self.readStatMap()
+		statEntry = self.statMap.get(glyphName)
+		if statEntry is None:
+			return None
+		fileStamp, srcHash, componentStamps = statEntry
+		try:
+			if list(getFileStamp(glyphPath)) != fileStamp:
+				return None
+			for compGlyphName, compFileStamp in componentStamps:
+				componentPath = self.getGlyphDefaultPath(compGlyphName)
+				if list(getFileStamp(componentPath)) != compFileStamp:
+					return None
+		except (KeyError, OSError):
+			return None
+		if not isinstance(srcHash, str):
+			# json gives unicode strings on Python 2.
+			try:
+				srcHash = str(srcHash)
+			except UnicodeError:
+				return None
+		return srcHash
+
+	def setStatHash(self, glyphName, fileStamp, srcHash, components):
+		if self.statMap is None:
+			self.readStatMap()
+		componentStamps = [[compGlyphName, list(compFileStamp)] for compGlyphName, componentPath, compFileStamp in components]
+		self.statMap[glyphName] = [list(fileStamp), srcHash, componentStamps]
+		self.statMapChanged = 1
+
 	def getCurGlyphPath(self, glyphName):
 		if self.curSrcDir == None:
 			self.curSrcDir = self.glyphDefaultDir
@@ -587,17 +706,16 @@ class UFOFontData:
 		except KeyError:
 			hashEntry = None
 
-		self.hashMapChanged = 1
 		# If the program always reads data from the default layer, and we have just created a new glyph in the processed layer, then reset the history.
 		if (not self.useProcessedLayer) and changed:
-			self.hashMap[glyphName] = [srcHash, [self.programName] ]
+			self.setHashEntry(glyphName, srcHash, [self.programName])
 			return
 		else:
 			try:
 				programHistoryIndex = historyList.index(self.programName)
 			except ValueError:
 				#If the program is not in the history list, add it.
-				historyList.append(self.programName)
+				self.setHashEntry(glyphName, srcHash, historyList + [self.programName])
 
 
 	def checkSkipGlyph(self, glyphName, newSrcHash, doAll):
@@ -631,14 +749,13 @@ class UFOFontData:
 				skip = True and (not doAll)
 			if not skip:
 				if not self.useProcessedLayer: # case for Checkoutlines
-					self.hashMapChanged = 1
-					self.hashMap[glyphName] = [newSrcHash, [self.programName] ]
+					self.setHashEntry(glyphName, newSrcHash, [self.programName])
 					glyphPath = self.getGlyphProcessedPath(glyphName)
 					if glyphPath and os.path.exists(glyphPath):
 						os.remove(glyphPath)
 				else:
 					if (programHistoryIndex < 0):
-						historyList.append(self.programName)
+						self.setHashEntry(glyphName, srcHash, historyList + [self.programName])
 		else:
 			if self.useProcessedLayer: # case for autohint
 				# default layer glyph and stored glyph hash differ,and useProcessedLayer is True
@@ -653,8 +770,7 @@ class UFOFontData:
 					skip = True
 
 			# If the source hash has changed, we need to delete the processed layer glyph.
-			self.hashMapChanged = 1
-			self.hashMap[glyphName] = [newSrcHash, [self.programName] ]
+			self.setHashEntry(glyphName, newSrcHash, [self.programName])
 			glyphPath = self.getGlyphProcessedPath(glyphName)
 			if glyphPath and os.path.exists(glyphPath):
 				os.remove(glyphPath)
@@ -664,8 +780,11 @@ class UFOFontData:
 
 	def getGlyphXML(self, glyphDir, glyphFileName):
 		glyphPath = os.path.join(glyphDir, glyphFileName) # default
-		etRoot = ET.ElementTree()
-		glifXML = etRoot.parse(glyphPath)
+		# Keep the data, for the native bez conversion.
+		fp = open(glyphPath, "rb")
+		glifData = fp.read()
+		fp.close()
+		glifXML = XML(glifData)
 		outlineXML = glifXML.find("outline")
 		try:
 			widthXML = glifXML.find("advance")
@@ -675,8 +794,8 @@ class UFOFontData:
 				width = 1000
 		except UFOParseError as e:
 			print("Error. skipping glyph '%s' because of parse error: %s" % (glyphName, e.message))
-			return None, None, None
-		return width, glifXML, outlineXML
+			return None, None, None, None
+		return width, glifXML, outlineXML, glifData
 
 	def getOrSkipGlyphXML(self, glyphName, doAll = 0):
 		# Get default glyph layer data, so we can check if the glyph has been edited since this program was last run.
@@ -684,14 +803,34 @@ class UFOFontData:
 		if len(self.glyphMap) == 0:
 			self.loadGlyphMap()
 		glyphFileName = self.glyphMap[glyphName]
-		width, glifXML, outlineXML = self.getGlyphXML(self.glyphDefaultDir, glyphFileName)
+
+		# If the glyph file and those of its components are unchanged, use the
+		# hash computed before, and skip the glyph without reading it if we
+		# can. All glyphs are read when doAll is set, so we do not keep file
+		# stamps then.
+		useStatMap = self.useHashMap and not doAll
+		newHash = None
+		if useStatMap:
+			glyphPath = os.path.join(self.glyphDefaultDir, glyphFileName)
+			newHash = self.getStatHash(glyphName, glyphPath)
+			if newHash == None:
+				fileStamp = getFileStamp(glyphPath)
+			else:
+				skip = self.checkSkipGlyph(glyphName, newHash, doAll)
+				if skip:
+					return None, None, skip, None
+
+		width, glifXML, outlineXML, glifData = self.getGlyphXML(self.glyphDefaultDir, glyphFileName)
 		if glifXML == None:
 			skip = 1
-			return None, None, skip
+			return None, None, skip, None
 
-		useDefaultGlyphDir = True # Hash is always from the default glyph layer.
-		newHash, dataList = self.buildGlyphHashValue(width, outlineXML, glyphName, useDefaultGlyphDir)
-		skip = self.checkSkipGlyph(glyphName, newHash, doAll)
+		if newHash == None:
+			useDefaultGlyphDir = True # Hash is always from the default glyph layer.
+			newHash, dataList, components = self.buildGlyphHash(width, outlineXML, glyphName, useDefaultGlyphDir)
+			skip = self.checkSkipGlyph(glyphName, newHash, doAll)
+			if useStatMap:
+				self.setStatHash(glyphName, fileStamp, newHash, components)
 
 		# If self.useProcessedLayer and there is a glyph in the processed layer, get the outline from that.
 		if self.useProcessedLayer and self.processedLayerGlyphMap:
@@ -701,12 +840,12 @@ class UFOFontData:
 				pass
 			glyphPath = os.path.join(self.glyphLayerDir, glyphFileName)
 			if os.path.exists(glyphPath):
-				width, glifXML, outlineXML = self.getGlyphXML(self.glyphLayerDir, glyphFileName)
+				width, glifXML, outlineXML, glifData = self.getGlyphXML(self.glyphLayerDir, glyphFileName)
 				if glifXML == None:
 					skip = 1
-					return None, None, skip
+					return None, None, skip, None
 
-		return width, outlineXML, skip
+		return width, outlineXML, skip, glifData
 
 
 	def getGlyphList(self):
@@ -954,7 +1093,29 @@ class UFOFontData:
 		glyphData must be the official <outline> XML from a GLIF.
 		We skip contours with only one point.
 		"""
-		dataList = ["w%s" % (str(width))]
+		hash, dataList, components = self.buildGlyphHash(width, outlineXML, glyphName, useDefaultGlyphDir, level)
+		return hash, dataList
+
+	def buildGlyphHash(self, width, outlineXML, glyphName, useDefaultGlyphDir, level = 0):
+		# Same as buildGlyphHashValue, also returning the components used.
+		dataList, depth, components = self.getOutlineHashData(outlineXML, glyphName, useDefaultGlyphDir, level)
+		# The width of the glyph is used for its components too.
+		widthData = "w%s" % (str(width))
+		dataList = [widthData if item is None else item for item in dataList]
+		data = "".join(dataList)
+		if len(data) < 128:
+			hash = data
+		else:
+			hash = hashlib.sha512(data.encode("utf-8")).hexdigest()
+		return hash, dataList, components
+
+	def getOutlineHashData(self, outlineXML, glyphName, useDefaultGlyphDir, level):
+		# Returns the hash data of the outline with None in place of the
+		# width, how many levels of components it has, and the name, path
+		# and file stamp of each component in it, at any level.
+		dataList = [None]
+		depth = 0
+		components = []
 		if level > 10:
 			raise UFOParseError("In parsing component, exceeded 10 levels of reference. '%s'. " % (glyphName))
 		# <outline> tag is optional per spec., e.g. space glyph does not necessarily have it.
@@ -980,29 +1141,7 @@ class UFOFontData:
 					except KeyError:
 						raise UFOParseError("'%s' is missing the 'base' attribute in a component. glyph '%s'." % (glyphName))
 
-					if useDefaultGlyphDir:
-						try:
-							componentPath = self.getGlyphDefaultPath(compGlyphName)
-						except KeyError:
-							raise UFOParseError("'%s' component glyph is missing from contents.plist." % (compGlyphName))
-					else:
-						# If we are not necessarily using the default layer for the main glyph, then a missing component
-						# may not have been processed, and may just be in the default layer. We need to look for component
-						# glyphs in the src list first, then in the defualt layer.
-						try:
-							componentPath = self.getGlyphSrcPath(compGlyphName)
-							if not os.path.exists(componentPath):
-								componentPath = self.getGlyphDefaultPath(compGlyphName)
-						except KeyError:
-							try:
-								componentPath = self.getGlyphDefaultPath(compGlyphName)
-							except KeyError:
-								raise UFOParseError("'%s' component glyph is missing from contents.plist." % (compGlyphName))
-
-					if not os.path.exists(componentPath):
-						raise UFOParseError("'%s' component file is missing: '%s'." % (compGlyphName, componentPath))
-
-					etRoot = ET.ElementTree()
+					componentPath = self.getHashComponentPath(compGlyphName, useDefaultGlyphDir)
 
 					# Collect transformm fields, if any.
 					for transformTag in ["xScale", "xyScale", "yxScale", "yScale", "xOffset", "yOffset"]:
@@ -1014,16 +1153,65 @@ class UFOFontData:
 							dataList.append(value)
 						except KeyError:
 							pass
-					componentXML = etRoot.parse(componentPath)
-					componentOutlineXML = componentXML.find("outline")
-					componentHash, componentDataList = self.buildGlyphHashValue(width, componentOutlineXML, glyphName, useDefaultGlyphDir, level+1)
+					component = self.getComponentGlyph(componentPath)
+					componentHashData = self.getCachedHashData(component, useDefaultGlyphDir)
+					if componentHashData is None:
+						componentHashData = self.getOutlineHashData(component.getOutline(), glyphName, useDefaultGlyphDir, level+1)
+						component.hashData[useDefaultGlyphDir] = componentHashData
+					componentDataList, componentDepth, componentComponents = componentHashData
+					if level + 1 + componentDepth > 10:
+						raise UFOParseError("In parsing component, exceeded 10 levels of reference. '%s'. " % (glyphName))
 					dataList.extend(componentDataList)
-		data = "".join(dataList)
-		if len(data) < 128:
-			hash = data
+					depth = max(depth, componentDepth + 1)
+					components.append((compGlyphName, componentPath, component.fileStamp))
+					components.extend(componentComponents)
+		return dataList, depth, components
+
+	def getCachedHashData(self, component, useDefaultGlyphDir):
+		# The hash data of a component can be used again only if all the
+		# components in it are still found in the same, unchanged files.
+		hashData = component.hashData.get(useDefaultGlyphDir)
+		if hashData is None:
+			return None
+		for compGlyphName, componentPath, fileStamp in hashData[2]:
+			if self.getHashComponentPath(compGlyphName, useDefaultGlyphDir) != componentPath:
+				return None
+			if self.getComponentGlyph(componentPath).fileStamp != fileStamp:
+				return None
+		return hashData
+
+	def getHashComponentPath(self, compGlyphName, useDefaultGlyphDir):
+		if useDefaultGlyphDir:
+			try:
+				componentPath = self.getGlyphDefaultPath(compGlyphName)
+			except KeyError:
+				raise UFOParseError("'%s' component glyph is missing from contents.plist." % (compGlyphName))
 		else:
-			hash = hashlib.sha512(data.encode("utf-8")).hexdigest()
-		return hash, dataList
+			# If we are not necessarily using the default layer for the main glyph, then a missing component
+			# may not have been processed, and may just be in the default layer. We need to look for component
+			# glyphs in the src list first, then in the defualt layer.
+			try:
+				componentPath = self.getGlyphSrcPath(compGlyphName)
+				if not os.path.exists(componentPath):
+					componentPath = self.getGlyphDefaultPath(compGlyphName)
+			except KeyError:
+				try:
+					componentPath = self.getGlyphDefaultPath(compGlyphName)
+				except KeyError:
+					raise UFOParseError("'%s' component glyph is missing from contents.plist." % (compGlyphName))
+
+		if not os.path.exists(componentPath):
+			raise UFOParseError("'%s' component file is missing: '%s'." % (compGlyphName, componentPath))
+		return componentPath
+
+	def getComponentGlyph(self, glyphPath):
+		# The cached component is used only while its file is unchanged.
+		fileStamp = getFileStamp(glyphPath)
+		component = self.componentCache.get(glyphPath)
+		if component is None or component.fileStamp != fileStamp:
+			component = ComponentGlyph(glyphPath, fileStamp)
+			self.componentCache[glyphPath] = component
+		return component
 
 	def getComponentOutline(self, componentItem):
 		try:
@@ -1031,6 +1219,14 @@ class UFOFontData:
 		except KeyError:
 			raise UFOParseError("'%s' attribute missing from component '%s'." % ("base", xmlToString(componentXML)))
 
+		compGlyphFilePath = self.getComponentPath(compGlyphName)
+		return self.getComponentGlyph(compGlyphFilePath).getOutline()
+
+	def getComponentData(self, compGlyphName):
+		compGlyphFilePath = self.getComponentPath(compGlyphName)
+		return self.getComponentGlyph(compGlyphFilePath).glifData
+
+	def getComponentPath(self, compGlyphName):
 		if not self.useProcessedLayer:
 			try:
 				compGlyphFilePath = self.getGlyphDefaultPath(compGlyphName)
@@ -1052,11 +1248,7 @@ class UFOFontData:
 
 		if not os.path.exists(compGlyphFilePath):
 			raise UFOParseError("'%s' component file is missing: '%s'." % (compGlyphName, compGlyphFilePath))
-
-		etRoot = ET.ElementTree()
-		glifXML = etRoot.parse(compGlyphFilePath)
-		outlineXML = glifXML.find("outline")
-		return outlineXML
+		return compGlyphFilePath
 
 	def copyTo(self, dstPath):
 		""" Copy UFO font to target path"""
@@ -1066,6 +1258,8 @@ class UFOFontData:
 		if self.hashMapChanged:
 			self.writeHashMap()
 			self.hashMapChanged = 0
+		if self.statMapChanged:
+			self.writeStatMap()
 		return
 
 	def clearHashMap(self):
@@ -1077,12 +1271,51 @@ class UFOFontData:
 		hashPath = os.path.join(hashDir, kAdobHashMapName)
 		if os.path.exists(hashPath):
 			os.remove(hashPath)
+		self.changedHashEntries = set()
+		statPath = os.path.join(hashDir, kAdobHashMapStatName)
+		if os.path.exists(statPath):
+			os.remove(statPath)
+		self.statMap = {}
+		self.statMapChanged = 0
 
 	def setWriteToDefault(self):
 		self.useProcessedLayer = False
 		self.writeToDefaultLayer = True
 		self.glyphWriteDir = self.glyphDefaultDir
 
+def formatHashEntry(glyphName, hashEntry):
+	return "'%s': %s," % (glyphName, hashEntry)
+
+# An entry as written by formatHashEntry, for the usual glyph names, hashes
+# and program names.
+hashEntryPattern = re.compile(r"^'([^'\\]*)': \['([^'\\]*)', \[((?:'[^'\\]*'(?:, )?)*)\]\],$")
+historyPattern = re.compile(r"'([^'\\]*)'")
+
+def parseHashMapLines(data):
+	"""
+	Reads the hash map entries from data written one per line by
+	formatHashEntry, without evaluating the whole map. Returns None if some
+	line is not in that format.
+	"""
+	hashMap = {}
+	for line in data.splitlines():
+		line = line.strip()
+		if line in ("{", "}", ""):
+			continue
+		match = hashEntryPattern.match(line)
+		if match:
+			glyphName, srcHash, history = match.groups()
+			hashMap[glyphName] = [srcHash, historyPattern.findall(history)]
+			continue
+		try:
+			item = ast.literal_eval("{%s}" % line)
+		except (SyntaxError, TypeError, ValueError):
+			return None
+		if not isinstance(item, dict):
+			return None
+		hashMap.update(item)
+	return hashMap
+
 def parseGlyphOrder(filePath):
 	orderMap = None
 	if os.path.exists(filePath):
@@ -1435,14 +1668,20 @@ def convertGlyphOutlineToBezString(outlineXML, ufoFontData, transform = None, le
 
 
 def convertGLIFToBez(ufoFontData, glyphName, beVerbose, doAll= 0):
-	width, outlineXML, skip = ufoFontData.getOrSkipGlyphXML(glyphName, doAll)
+	width, outlineXML, skip, glifData = ufoFontData.getOrSkipGlyphXML(glyphName, doAll)
 	if skip:
 		return None, width
 
 	if outlineXML == None:
 		return None, width
 
-	bezString = convertGlyphOutlineToBezString(outlineXML, ufoFontData)
+	# The native conversion gives the same result, but leaves the outlines it
+	# does not handle, including those with errors to report, to the Python
+	# code.
+	bezString = _psautohint.glif_to_bez(glifData, ufoFontData.getComponentData,
+										ufoFontData.allowDecimalCoords)
+	if bezString is None:
+		bezString = convertGlyphOutlineToBezString(outlineXML, ufoFontData)
 	bezString = (r"%%%s%ssc " % (glyphName, os.linesep)) + bezString + " ed"
 	return bezString, width
 